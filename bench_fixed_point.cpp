@@ -0,0 +1,75 @@
+//microbenchmark for fixed_point.h: reference orbit iterations (z = z^2 + c) per second at a range of precisions,
+//doing z^2 with multiplications (x*x - y*y, 2*x*y) vs squarings (x^2 - y^2, (x+y)^2 - x^2 - y^2) like computeReferenceOrbit()
+//build with `make bench`, then run `./bench_fixed_point.out [<seconds per test>]`
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+#include "fixed_point.h"
+
+//c is inside the main cardioid, so the orbit never escapes no matter how long it runs
+const std::string C_X = "-0.51234567890123456789012345678901234567890123456789";
+const std::string C_Y = "0.25432109876543210987654321098765432109876543210987";
+const int BENCH_ROUNDS = 5;
+
+template<typename Iteration>
+double iterationsPerSecond(int fraction_limbs, double seconds, Iteration iteration) {
+	const FixedPoint cx = FixedPoint::fromString(C_X, fraction_limbs);
+	const FixedPoint cy = FixedPoint::fromString(C_Y, fraction_limbs);
+	FixedPoint x(fraction_limbs), y(fraction_limbs);
+
+	uint64_t iterations = 0;
+	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed{};
+	do {
+		//checking the clock every iteration would cost as much as an iteration at low precision
+		for (int i = 0; i < 64; i++) {
+			iteration(x, y, cx, cy);
+		}
+		iterations += 64;
+		elapsed = std::chrono::steady_clock::now() - startTime;
+	} while (elapsed.count() < seconds);
+
+	if (!(x.toDouble()*x.toDouble() + y.toDouble()*y.toDouble() < 2*2)) {
+		std::cerr << "orbit escaped at " << 32 * fraction_limbs << " bits, the arithmetic is broken" << std::endl;
+	}
+	return iterations / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+	const double seconds = (argc > 1) ? std::stod(argv[1]) : 0.25;
+
+	std::cout << std::setw(8) << "bits" << std::setw(16) << "multiply it/s" << std::setw(16) << "square it/s" << std::setw(10) << "speedup" << std::endl;
+	for (int bits = 64; bits <= 16384; bits *= 2) {
+		const int fraction_limbs = bits / 32;
+
+		//both have to give the exact same truncated square (of something with every limb in use)
+		const FixedPoint cy = FixedPoint::fromString(C_Y, fraction_limbs);
+		FixedPoint check = FixedPoint::fromString(C_X, fraction_limbs);
+		for (int i = 0; i < 20; i++) {
+			check = check * cy + cy;
+		}
+		if (!(check.square() == check * check)) {
+			std::cerr << "square() doesn't match multiplying at " << bits << " bits" << std::endl;
+		}
+
+		//the two take turns over a few short runs, keeping the best of each, so the clock speed drifting in between doesn't decide which wins
+		double multiply = 0, square = 0;
+		for (int round = 0; round < BENCH_ROUNDS; round++) {
+			multiply = std::max(multiply, iterationsPerSecond(fraction_limbs, seconds / BENCH_ROUNDS, [](FixedPoint& x, FixedPoint& y, const FixedPoint& cx, const FixedPoint& cy) {
+				const FixedPoint xx = x*x, yy = y*y, xy = x*y;
+				x = xx - yy + cx;
+				y = xy + xy + cy;
+			}));
+			square = std::max(square, iterationsPerSecond(fraction_limbs, seconds / BENCH_ROUNDS, [](FixedPoint& x, FixedPoint& y, const FixedPoint& cx, const FixedPoint& cy) {
+				const FixedPoint xx = x.square(), yy = y.square();
+				y = (x + y).square() - xx - yy + cy;
+				x = xx - yy + cx;
+			}));
+		}
+		std::cout << std::setw(8) << bits << std::setw(16) << std::fixed << std::setprecision(0) << multiply << std::setw(16) << square
+			<< std::setw(9) << std::setprecision(2) << square / multiply << "x" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+//double-double: a number stored as the unevaluated sum hi + lo of two doubles, with |lo| <= ulp(hi)/2, for ~106 bits of precision
+//(not far from twice long double's bits, and made of plain double math, so with FMA the SIMD kernels run it about as fast as long double
+//with AVX2 and ~1.3x faster with AVX-512; without FMA it's scalar with Dekker's product, ~5x slower than long double)
+//everything relies on the rounding errors of + and * being recoverable exactly, which needs -fno-associative-math if -ffast-math is on,
+//and -ffp-contract=off so a * b + c never gets fused on some builds but not others
+
+struct DoubleDouble {
+	double hi, lo;
+
+	constexpr DoubleDouble(double hi = 0, double lo = 0) : hi(hi), lo(lo) {}
+	explicit operator double() const { return hi; }
+
+	friend DoubleDouble operator-(DoubleDouble a) { return DoubleDouble(-a.hi, -a.lo); }
+	friend DoubleDouble operator+(DoubleDouble a, DoubleDouble b);
+	friend DoubleDouble operator-(DoubleDouble a, DoubleDouble b) { return a + -b; }
+	friend DoubleDouble operator*(DoubleDouble a, DoubleDouble b);
+	friend DoubleDouble operator/(DoubleDouble a, DoubleDouble b);
+
+	DoubleDouble& operator+=(DoubleDouble b) { return *this = *this + b; }
+	DoubleDouble& operator-=(DoubleDouble b) { return *this = *this - b; }
+	DoubleDouble& operator*=(DoubleDouble b) { return *this = *this * b; }
+
+	friend bool operator<(DoubleDouble a, DoubleDouble b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+	friend bool operator<=(DoubleDouble a, DoubleDouble b) { return !(b < a); }
+};
+
+//a + b = s + error exactly
+inline DoubleDouble twoSum(double a, double b) {
+	const double s = a + b;
+	const double b_part = s - a;
+	return DoubleDouble(s, (a - (s - b_part)) + (b - b_part));
+}
+
+//same as twoSum(), but only when |a| >= |b|
+inline DoubleDouble quickTwoSum(double a, double b) {
+	const double s = a + b;
+	return DoubleDouble(s, b - (s - a));
+}
+
+//a * b = p + error exactly
+inline DoubleDouble twoProd(double a, double b) {
+	const double p = a * b;
+#if defined(__FP_FAST_FMA)
+	return DoubleDouble(p, std::fma(a, b, -p));
+#else
+	//without FMA, std::fma() is a libm call that does it in software (hundreds of times slower), so it's Dekker's product instead:
+	//each factor gets split into two 26-bit halves, whose products are all exact
+	const double a_big = 134217729.0 * a, b_big = 134217729.0 * b; //2^27 + 1
+	const double a_hi = a_big - (a_big - a), b_hi = b_big - (b_big - b);
+	const double a_lo = a - a_hi, b_lo = b - b_hi;
+	return DoubleDouble(p, ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo);
+#endif
+}
+
+inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+	//the lo parts just get added together instead of being error-corrected too: slightly less accurate, but much faster
+	const DoubleDouble s = twoSum(a.hi, b.hi);
+	return quickTwoSum(s.hi, s.lo + (a.lo + b.lo));
+}
+
+inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+	//a.hi*b.hi's rounding error comes out exactly either way, and the cross terms are plain products,
+	//so builds with and without FMA get the same bits (as long as -ffp-contract=off stops the compiler from fusing any of it)
+	const DoubleDouble p = twoProd(a.hi, b.hi);
+	return quickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+inline DoubleDouble operator/(DoubleDouble a, DoubleDouble b) {
+	//long division: a double's worth of quotient, then another from the remainder
+	const double q1 = a.hi / b.hi;
+	const DoubleDouble remainder = a - b * DoubleDouble(q1);
+	return quickTwoSum(q1, remainder.hi / b.hi);
+}
+
+template<> class std::numeric_limits<DoubleDouble> {
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr int digits = 2 * std::numeric_limits<double>::digits;
+	static constexpr DoubleDouble epsilon() { return DoubleDouble(0x1p-104); }
+};
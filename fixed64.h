@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+//64-bit fixed point: two's complement with FRACTION_BITS fraction bits, so 7 integer bits (|x| < 128) and 2^-56 resolution (a little finer than double around 1)
+//it's all integer math with exactly one way to round (products of the magnitudes get truncated), so it gives the same results everywhere,
+//whatever the compiler flags or instruction set; the SIMD versions in kernels_impl.h do the exact same thing
+//everything a pixel's orbit goes through before escaping stays below 128 as long as |cx|, |cy| <= 2 (|z|^2 <= (2^2 + 2*sqrt(2))^2 < 47)
+
+struct Fixed64 {
+	static constexpr int FRACTION_BITS = 56;
+	int64_t raw;
+
+	constexpr Fixed64() : raw(0) {}
+	constexpr Fixed64(int i) : raw(int64_t(i) * (int64_t(1) << FRACTION_BITS)) {}
+	//only meant for constants that are exact in binary (.25, .5, ...), never for pixel coordinates, which have to come out the same everywhere
+	constexpr Fixed64(double d) : raw(int64_t(d * double(int64_t(1) << FRACTION_BITS))) {}
+	explicit operator double() const { return double(raw) / double(int64_t(1) << FRACTION_BITS); }
+	static constexpr Fixed64 fromRaw(int64_t raw) {
+		Fixed64 result;
+		result.raw = raw;
+		return result;
+	}
+
+	//through uint64_t, so overflow wraps around like the SIMD versions instead of being undefined (escaped and inactive lanes keep iterating on huge values)
+	friend constexpr Fixed64 operator-(Fixed64 a) { return fromRaw(int64_t(-uint64_t(a.raw))); }
+	friend constexpr Fixed64 operator+(Fixed64 a, Fixed64 b) { return fromRaw(int64_t(uint64_t(a.raw) + uint64_t(b.raw))); }
+	friend constexpr Fixed64 operator-(Fixed64 a, Fixed64 b) { return fromRaw(int64_t(uint64_t(a.raw) - uint64_t(b.raw))); }
+	friend Fixed64 operator*(Fixed64 a, Fixed64 b);
+	friend Fixed64 operator/(Fixed64 a, Fixed64 b);
+
+	Fixed64& operator+=(Fixed64 b) { return *this = *this + b; }
+	Fixed64& operator-=(Fixed64 b) { return *this = *this - b; }
+	Fixed64& operator*=(Fixed64 b) { return *this = *this * b; }
+
+	friend constexpr bool operator<(Fixed64 a, Fixed64 b) { return a.raw < b.raw; }
+	friend constexpr bool operator<=(Fixed64 a, Fixed64 b) { return a.raw <= b.raw; }
+};
+
+inline Fixed64 operator*(Fixed64 a, Fixed64 b) {
+	const uint64_t a_magnitude = (a.raw < 0) ? -uint64_t(a.raw) : uint64_t(a.raw);
+	const uint64_t b_magnitude = (b.raw < 0) ? -uint64_t(b.raw) : uint64_t(b.raw);
+	const uint64_t product = uint64_t((unsigned __int128)a_magnitude * b_magnitude >> Fixed64::FRACTION_BITS);
+	return Fixed64::fromRaw(int64_t(((a.raw < 0) != (b.raw < 0)) ? -product : product));
+}
+
+inline Fixed64 operator/(Fixed64 a, Fixed64 b) {
+	return Fixed64::fromRaw(int64_t(((__int128)a.raw << Fixed64::FRACTION_BITS) / b.raw));
+}
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+//fixed-point numbers with as many 32-bit fraction limbs as needed, for when even long double can't tell pixels apart:
+//limbs are least significant first, stored as one big two's complement number, with the last limb being the integer part
+//(the integer part only has to hold the Mandelbrot set's |z| < 2 plus intermediate results, so one limb is plenty)
+
+//squaring switches from schoolbook to Karatsuba at this many limbs (see bench_fixed_point.cpp)
+const size_t KARATSUBA_THRESHOLD = 48;
+
+//unsigned arithmetic on raw limbs, least significant first
+namespace limb_math {
+	//dst += src, carrying as far into dst as needed
+	inline void addInto(uint32_t* dst, size_t dst_size, const uint32_t* src, size_t src_size) {
+		uint64_t carry = 0;
+		for (size_t i = 0; i < dst_size && (i < src_size || carry); i++) {
+			carry += uint64_t(dst[i]) + (i < src_size ? src[i] : 0);
+			dst[i] = uint32_t(carry);
+			carry >>= 32;
+		}
+	}
+
+	//dst -= src, where dst >= src
+	inline void subtractFrom(uint32_t* dst, size_t dst_size, const uint32_t* src, size_t src_size) {
+		uint64_t borrow = 0;
+		for (size_t i = 0; i < dst_size && (i < src_size || borrow); i++) {
+			const uint64_t subtrahend = uint64_t(i < src_size ? src[i] : 0) + borrow;
+			borrow = (dst[i] < subtrahend);
+			dst[i] = uint32_t(dst[i] - subtrahend);
+		}
+	}
+
+	//product gets all 2n limbs of a*b
+	inline void multiply(const uint32_t* a, const uint32_t* b, size_t n, uint32_t* product) {
+		std::fill_n(product, 2 * n, 0);
+		for (size_t i = 0; i < n; i++) {
+			uint64_t carry = 0;
+			for (size_t j = 0; j < n; j++) {
+				carry += uint64_t(a[i]) * b[j] + product[i + j];
+				product[i + j] = uint32_t(carry);
+				carry >>= 32;
+			}
+			product[i + n] = uint32_t(carry);
+		}
+	}
+
+	//same as multiply(a, a, ...), but every cross product a[i]*a[j] only gets computed once then doubled
+	inline void squareSchoolbook(const uint32_t* a, size_t n, uint32_t* product) {
+		std::fill_n(product, 2 * n, 0);
+		for (size_t i = 0; i < n; i++) {
+			uint64_t carry = 0;
+			for (size_t j = i + 1; j < n; j++) {
+				carry += uint64_t(a[i]) * a[j] + product[i + j];
+				product[i + j] = uint32_t(carry);
+				carry >>= 32;
+			}
+			product[i + n] = uint32_t(carry);
+		}
+		uint32_t top_bit = 0;
+		for (size_t i = 0; i < 2 * n; i++) {
+			const uint32_t doubled = (product[i] << 1) | top_bit;
+			top_bit = product[i] >> 31;
+			product[i] = doubled;
+		}
+		uint64_t carry = 0;
+		for (size_t i = 0; i < n; i++) {
+			const uint64_t square = uint64_t(a[i]) * a[i];
+			carry += uint64_t(product[2*i]) + uint32_t(square);
+			product[2*i] = uint32_t(carry);
+			carry >>= 32;
+			carry += uint64_t(product[2*i + 1]) + (square >> 32);
+			product[2*i + 1] = uint32_t(carry);
+			carry >>= 32;
+		}
+	}
+
+	//with a = high*B + low: a^2 = high^2*B^2 + 2*high*low*B + low^2, and 2*high*low = (high + low)^2 - high^2 - low^2,
+	//so it's 3 squares of half the size instead of 4
+	inline void square(const uint32_t* a, size_t n, uint32_t* product) {
+		if (n < KARATSUBA_THRESHOLD) {
+			squareSchoolbook(a, n, product);
+			return;
+		}
+		const size_t low_size = n / 2, high_size = n - low_size;
+		std::vector<uint32_t> sum(a + low_size, a + n);
+		sum.push_back(0);
+		addInto(sum.data(), sum.size(), a, low_size);
+		std::vector<uint32_t> middle(2 * sum.size());
+		square(sum.data(), sum.size(), middle.data());
+
+		std::fill_n(product, 2 * n, 0);
+		square(a, low_size, product);
+		square(a + low_size, high_size, product + 2 * low_size);
+		subtractFrom(middle.data(), middle.size(), product, 2 * low_size);
+		subtractFrom(middle.data(), middle.size(), product + 2 * low_size, 2 * high_size);
+		addInto(product + low_size, 2 * n - low_size, middle.data(), std::min(middle.size(), 2 * n - low_size));
+	}
+}
+
+class FixedPoint {
+public:
+	explicit FixedPoint(int fraction_limbs = 2) : limbs(fraction_limbs + 1, 0) {}
+
+	//decimal, optionally with a sign and an exponent (like "-1.25" or "3.5e-20"); anything past the precision gets truncated
+	static FixedPoint fromString(const std::string& str, int fraction_limbs);
+	static int fractionLimbsFor(const std::string& str); //enough for fromString() to keep every digit of str, wherever its exponent puts them
+	static FixedPoint fromDouble(double d, int fraction_limbs);
+	double toDouble() const;
+	int64_t toInt64(int fraction_bits) const; //two's complement with 0 < fraction_bits < 64 fraction bits, rounded down
+
+	int fractionLimbs() const { return int(limbs.size()) - 1; }
+	FixedPoint withFractionLimbs(int fraction_limbs) const; //truncates or pads with zeros
+
+	bool isNegative() const { return int32_t(limbs.back()) < 0; }
+	bool operator==(const FixedPoint& other) const = default;
+	FixedPoint operator-() const;
+	FixedPoint operator+(const FixedPoint& other) const;
+	FixedPoint operator-(const FixedPoint& other) const;
+	FixedPoint operator*(const FixedPoint& other) const;
+	FixedPoint square() const; //same as *this * *this, just faster
+	FixedPoint half() const; //exact, unlike multiplying by 0.5
+
+private:
+	std::vector<uint32_t> limbs;
+
+	//str's sign and digits, and how many of the digits come before the decimal point once the exponent is applied (can be negative or past the end)
+	static void splitDecimal(const std::string& str, bool& negative, std::string& digits, int& point);
+
+	//magnitudes, for multiplying
+	FixedPoint abs() const { return isNegative() ? -*this : *this; }
+};
+
+inline FixedPoint FixedPoint::operator-() const {
+	FixedPoint result = *this;
+	uint64_t carry = 1;
+	for (uint32_t& limb : result.limbs) {
+		carry += uint32_t(~limb);
+		limb = uint32_t(carry);
+		carry >>= 32;
+	}
+	return result;
+}
+
+inline FixedPoint FixedPoint::operator+(const FixedPoint& other) const {
+	FixedPoint result = *this;
+	uint64_t carry = 0;
+	for (size_t i = 0; i < limbs.size(); i++) {
+		carry += uint64_t(limbs[i]) + other.limbs[i];
+		result.limbs[i] = uint32_t(carry);
+		carry >>= 32;
+	}
+	return result;
+}
+
+inline FixedPoint FixedPoint::operator-(const FixedPoint& other) const {
+	return *this + -other;
+}
+
+inline FixedPoint FixedPoint::operator*(const FixedPoint& other) const {
+	//schoolbook multiplication of the magnitudes; only the limbs at or above the fraction limbs are kept
+	const FixedPoint a = abs(), b = other.abs();
+	const size_t n = limbs.size();
+	std::vector<uint32_t> product(2 * n);
+	limb_math::multiply(a.limbs.data(), b.limbs.data(), n, product.data());
+
+	FixedPoint result(fractionLimbs());
+	std::copy_n(product.begin() + fractionLimbs(), n, result.limbs.begin());
+	return (isNegative() != other.isNegative()) ? -result : result;
+}
+
+inline FixedPoint FixedPoint::square() const {
+	const FixedPoint a = abs();
+	const size_t n = limbs.size();
+	std::vector<uint32_t> product(2 * n);
+	limb_math::square(a.limbs.data(), n, product.data());
+
+	FixedPoint result(fractionLimbs());
+	std::copy_n(product.begin() + fractionLimbs(), n, result.limbs.begin());
+	return result;
+}
+
+inline FixedPoint FixedPoint::half() const {
+	FixedPoint result = *this;
+	for (size_t i = 0; i < limbs.size(); i++) {
+		const uint32_t next = (i + 1 < limbs.size()) ? limbs[i + 1] : uint32_t(int32_t(limbs[i]) >> 31); //sign extension at the top
+		result.limbs[i] = (limbs[i] >> 1) | (next << 31);
+	}
+	return result;
+}
+
+inline FixedPoint FixedPoint::withFractionLimbs(int fraction_limbs) const {
+	FixedPoint result(fraction_limbs);
+	const int shift = fraction_limbs - fractionLimbs(); //how many limbs the fraction grows by
+	for (int i = 0; i <= fraction_limbs; i++) {
+		const int source = i - shift;
+		if (source >= 0) {
+			result.limbs[i] = limbs[source];
+		}
+	}
+	return result;
+}
+
+inline double FixedPoint::toDouble() const {
+	const FixedPoint magnitude = abs();
+	double result = 0;
+	for (size_t i = 0; i < limbs.size(); i++) {
+		result += std::ldexp(double(magnitude.limbs[i]), 32 * (int(i) - fractionLimbs()));
+	}
+	return isNegative() ? -result : result;
+}
+
+inline int64_t FixedPoint::toInt64(int fraction_bits) const {
+	//the top 64 bits of the fraction, then the integer limb above them
+	uint64_t fraction = 0;
+	for (int i = 1; i <= 2 && fractionLimbs() - i >= 0; i++) {
+		fraction |= uint64_t(limbs[fractionLimbs() - i]) << (64 - 32 * i);
+	}
+	return int64_t(uint64_t(int64_t(int32_t(limbs.back()))) << fraction_bits) | int64_t(fraction >> (64 - fraction_bits));
+}
+
+inline FixedPoint FixedPoint::fromDouble(double d, int fraction_limbs) {
+	FixedPoint result(fraction_limbs);
+	double magnitude = std::fabs(d);
+	if (magnitude >= 2147483648.0) {
+		throw std::runtime_error("Number too big for FixedPoint: " + std::to_string(d));
+	}
+	//peel off 32 bits at a time; scaling by 2^32 and flooring is exact for doubles
+	for (int i = fraction_limbs; i >= 0; i--) {
+		const double limb = std::floor(magnitude);
+		result.limbs[i] = uint32_t(limb);
+		magnitude = std::ldexp(magnitude - limb, 32);
+	}
+	return (d < 0) ? -result : result;
+}
+
+inline void FixedPoint::splitDecimal(const std::string& str, bool& negative, std::string& digits, int& point) {
+	size_t pos = 0;
+	negative = false;
+	if (pos < str.size() && (str[pos] == '-' || str[pos] == '+')) {
+		negative = (str[pos] == '-');
+		pos++;
+	}
+
+	//collect the digits and where the decimal point goes
+	digits.clear();
+	point = -1;
+	for (; pos < str.size() && str[pos] != 'e' && str[pos] != 'E'; pos++) {
+		if (str[pos] == '.' && point < 0) {
+			point = int(digits.size());
+		} else if (str[pos] >= '0' && str[pos] <= '9') {
+			digits.push_back(str[pos]);
+		} else {
+			throw std::runtime_error("Not a number: \"" + str + "\"");
+		}
+	}
+	if (digits.empty()) {
+		throw std::runtime_error("Not a number: \"" + str + "\"");
+	}
+	if (point < 0) {
+		point = int(digits.size());
+	}
+	if (pos < str.size()) {
+		point += std::stoi(str.substr(pos + 1));
+	}
+}
+
+inline int FixedPoint::fractionLimbsFor(const std::string& str) {
+	bool negative;
+	std::string digits;
+	int point;
+	splitDecimal(str, negative, digits, point);
+	//the last digit is 10^-(digits after the point), and each decimal digit is log2(10) bits
+	const int fraction_digits = std::max(0, int(digits.size()) - point);
+	return int(std::ceil(fraction_digits * 3.3219280948873623 / 32));
+}
+
+inline FixedPoint FixedPoint::fromString(const std::string& str, int fraction_limbs) {
+	bool negative;
+	std::string digits;
+	int point;
+	splitDecimal(str, negative, digits, point);
+
+	//split into the integer part and the fraction's digits
+	if (point < 0) {
+		digits.insert(0, size_t(-point), '0');
+		point = 0;
+	}
+	if (point > int(digits.size())) {
+		digits.append(point - digits.size(), '0');
+	}
+	const std::string integer_digits = digits.substr(0, point);
+	std::vector<uint8_t> fraction_digits(digits.begin() + point, digits.end());
+	for (uint8_t& digit : fraction_digits) {
+		digit -= '0';
+	}
+
+	FixedPoint result(fraction_limbs);
+	const uint64_t integer = integer_digits.empty() ? 0 : std::stoull(integer_digits);
+	if (integer >= 2147483648ull) {
+		throw std::runtime_error("Number too big for FixedPoint: \"" + str + "\"");
+	}
+	result.limbs[fraction_limbs] = uint32_t(integer);
+
+	//multiplying the fraction by 2^32 pushes the next limb out the top, one limb at a time
+	for (int i = fraction_limbs - 1; i >= 0; i--) {
+		uint64_t carry = 0;
+		for (size_t d = fraction_digits.size(); d-- > 0; ) {
+			const uint64_t value = (uint64_t(fraction_digits[d]) << 32) + carry;
+			fraction_digits[d] = uint8_t(value % 10);
+			carry = value / 10;
+		}
+		result.limbs[i] = uint32_t(carry);
+	}
+	return negative ? -result : result;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//what main.cpp shares with the kernels, which get compiled once per instruction set level (kernels_impl.h)
+//so the same binary can run the best ones the CPU supports
+
+//iteration counts get stored as uint16_t, or as uint32_t when MAX_ITER is past 65533 (the top two values of either are kept free as markers),
+//so the kernels take the count type as a template parameter and get compiled for both
+extern int MAX_ITER;
+
+enum class KernelType { scalar, interleaved, simd, refill };
+extern KernelType KERNEL_TYPE;
+
+extern bool CARDIOID_CHECK;
+extern bool PERIODICITY_CHECK;
+extern bool DERIVATIVE_CHECK;
+
+//kernel counters, kept per thread then summed into the globals:
+//SIMD lane usage (lane-iterations that belonged to a pixel vs all lane-iterations run), and pixels that never needed iterating
+struct KernelStats {
+	uint64_t used = 0;
+	uint64_t total = 0;
+	uint64_t cardioid = 0;
+	uint64_t periodic = 0;
+	uint64_t derivative = 0; //pixels the derivative check found inside
+	uint64_t pixels = 0; //pixels handed to a kernel at all
+	uint64_t glitched = 0; //pixels still glitched after running out of references
+	uint64_t skipped = 0; //iterations jumped over by BLA steps, per pixel
+};
+
+//pixel sources: they hand the kernels pixels in order, and the kernels write the i-th one's iteration count to iterations_arr[i]
+
+//pixel i is (cx_arr[i % width], cy_arr[i / width])
+template<typename T>
+struct GridPixels {
+	const T* cx_arr;
+	int width;
+	const T* cy_arr;
+	int rows;
+	int x = 0, y = 0;
+
+	int size() const { return width * rows; }
+	void next(T& cx, T& cy) {
+		cx = cx_arr[x];
+		cy = cy_arr[y];
+		if (++x == width) {
+			x = 0;
+			y++;
+		}
+	}
+};
+
+//pixel i is (cx_arr[i], cy_arr[i])
+template<typename T>
+struct ListPixels {
+	const T* cx_arr;
+	const T* cy_arr;
+	int count;
+	int i = 0;
+
+	int size() const { return count; }
+	void next(T& cx, T& cy) {
+		cx = cx_arr[i];
+		cy = cy_arr[i];
+		i++;
+	}
+};
+
+//pixel i is (cx_arr[i], cy_arr[i]), carrying its orbit along: it picks up at z = (zx_arr[i], zy_arr[i]) after start_iterations iterations instead of at 0,
+//and if it reaches MAX_ITER without escaping or getting caught in a cycle, its z gets written back and running_arr[i] gets set (0 otherwise),
+//so a later run with a higher MAX_ITER can pick it up from there (see --save-orbits in main.cpp)
+template<typename T>
+struct OrbitPixels {
+	const T* cx_arr;
+	const T* cy_arr;
+	T* zx_arr;
+	T* zy_arr;
+	uint8_t* running_arr;
+	int start_iterations;
+	int count;
+	int i = 0;
+
+	int size() const { return count; }
+	void next(T& cx, T& cy) {
+		cx = cx_arr[i];
+		cy = cy_arr[i];
+		i++;
+	}
+};
+
+template<typename Pixels> constexpr bool carries_orbits = false;
+template<typename T> constexpr bool carries_orbits<OrbitPixels<T>> = true;
+
+//perturbation's reference orbits (see main.cpp)
+
+struct BlaStep {
+	double ax, ay;
+	double bx, by;
+	double radius2; //|dz|^2 has to be below this
+};
+
+//levels[k][j] goes from iteration j*2^k to (j+1)*2^k
+struct BlaTable {
+	std::vector<std::vector<BlaStep>> levels;
+
+	//the step over 2^level iterations starting at iteration n, if there is one
+	//(the kernels go up a level at a time while it's valid: one level-1 check is cheap enough to do every other iteration)
+	const BlaStep* step(int n, int level) const {
+		if (level >= int(levels.size()) || (n & ((1 << level) - 1)) != 0) {
+			return nullptr;
+		}
+		const size_t j = size_t(n) >> level;
+		return (j < levels[level].size()) ? &levels[level][j] : nullptr;
+	}
+};
+
+struct ReferenceOrbit {
+	double dcx = 0, dcy = 0; //from the center
+	std::vector<double> x, y; //Z_0 through Z_length(), stopping early if it escapes
+	std::vector<double> glitch_below; //GLITCH_TOLERANCE*|Z_n|^2
+	BlaTable bla; //empty without BLA_SKIPPING
+
+	int length() const { return int(x.size()) - 1; }
+};
+
+//the instruction set levels the kernels get compiled for on x86-64: kernels_sse2.cpp (plain x86-64), kernels_avx2.cpp (x86-64-v3: AVX2 and FMA),
+//and kernels_avx512.cpp (x86-64-v4: AVX-512F/BW/CD/DQ/VL), each with the same functions in its own namespace
+//anywhere else there's only kernels_generic.cpp, with no SIMD
+#if defined(__x86_64__)
+enum class SimdLevel { sse2, avx2, avx512 };
+
+namespace isa_sse2 {
+	template<typename T, typename Pixels, typename Count> void run_kernel(Pixels pixels, Count* iterations_arr, KernelStats& stats);
+	template<typename T> void perturbation_kernel(const T* dcx_arr, const T* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, T* glitch_size, KernelStats& stats);
+}
+namespace isa_avx2 {
+	template<typename T, typename Pixels, typename Count> void run_kernel(Pixels pixels, Count* iterations_arr, KernelStats& stats);
+	template<typename T> void perturbation_kernel(const T* dcx_arr, const T* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, T* glitch_size, KernelStats& stats);
+}
+namespace isa_avx512 {
+	template<typename T, typename Pixels, typename Count> void run_kernel(Pixels pixels, Count* iterations_arr, KernelStats& stats);
+	template<typename T> void perturbation_kernel(const T* dcx_arr, const T* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, T* glitch_size, KernelStats& stats);
+}
+#else
+enum class SimdLevel { generic };
+
+namespace isa_generic {
+	template<typename T, typename Pixels, typename Count> void run_kernel(Pixels pixels, Count* iterations_arr, KernelStats& stats);
+	template<typename T> void perturbation_kernel(const T* dcx_arr, const T* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, T* glitch_size, KernelStats& stats);
+}
+#endif
@@ -0,0 +1,5 @@
+//the kernels for CPUs with AVX2 and FMA (Haswell and up): everything x86-64-v3 adds
+#define KERNEL_NAMESPACE isa_avx2
+#define KERNEL_TARGET "sse3,ssse3,sse4.1,sse4.2,popcnt,cx16,sahf,avx,avx2,bmi,bmi2,f16c,fma,lzcnt,movbe,xsave"
+#define KERNEL_AVX2
+#include "kernels_impl.h"
@@ -0,0 +1,5 @@
+//the kernels for CPUs with AVX-512 (Skylake-X and up): everything x86-64-v4 adds
+#define KERNEL_NAMESPACE isa_avx512
+#define KERNEL_TARGET "sse3,ssse3,sse4.1,sse4.2,popcnt,cx16,sahf,avx,avx2,bmi,bmi2,f16c,fma,lzcnt,movbe,xsave,avx512f,avx512bw,avx512cd,avx512dq,avx512vl"
+#define KERNEL_AVX512
+#include "kernels_impl.h"
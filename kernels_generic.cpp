@@ -0,0 +1,3 @@
+//the kernels for anything that isn't x86-64: one build, with no SIMD (every type gets the interleaved scalar orbits)
+#define KERNEL_NAMESPACE isa_generic
+#include "kernels_impl.h"
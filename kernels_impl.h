@@ -0,0 +1,1016 @@
+//the escape-time and perturbation kernels: every kernels_*.cpp defines KERNEL_NAMESPACE and includes this
+//on x86-64, every file gets built for plain x86-64 and the kernels_*.cpp for higher levels also define KERNEL_TARGET,
+//which only the code in KERNEL_NAMESPACE gets compiled for: everything included here is shared with main.cpp and the other levels,
+//and the linker keeps whichever copy it likes. They also define KERNEL_AVX2 or KERNEL_AVX512 for simd_traits to pick from,
+//since in C++ the pragma doesn't change __AVX2__ and friends
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <bit>
+#include <type_traits>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "kernels.h"
+#include "double_double.h"
+#include "fixed64.h"
+
+#if defined(__x86_64__) && defined(__AVX__)
+#error "the kernels have to be built with -march=x86-64 (see the Makefile), or the functions they share with main.cpp won't run on older CPUs"
+#endif
+
+#if defined(KERNEL_TARGET)
+//(#pragma GCC target doesn't expand macros, so it has to go through _Pragma)
+#define KERNEL_PRAGMA_STRING(x) #x
+#define KERNEL_PRAGMA(x) _Pragma(KERNEL_PRAGMA_STRING(x))
+#pragma GCC push_options
+KERNEL_PRAGMA(GCC target(KERNEL_TARGET))
+#endif
+
+namespace KERNEL_NAMESPACE {
+
+//SIMD wrappers:
+//simd_traits<T>::width is how many pixels one vector holds; width 1 means no SIMD support, so the kernels interleave scalar orbits instead (interleaved_traits below)
+//masks are kept in their native form because AVX2 and AVX-512 represent them very differently; blend() takes a bitmask since that's what the kernels track
+
+template<typename T> struct simd_traits {
+	static constexpr int width = 1;
+};
+
+//only x86-64 has SIMD versions; anywhere else (ARM64, say), every type uses the interleaved scalar orbits, which for Fixed64 is the same integer math
+#if defined(__x86_64__)
+#if defined(KERNEL_AVX512)
+template<> struct simd_traits<float> {
+	static constexpr int width = 16;
+	typedef __m512 vec;
+	typedef __mmask16 mask;
+	static vec load(const float* p) { return _mm512_loadu_ps(p); }
+	static void store(float* p, vec v) { _mm512_storeu_ps(p, v); }
+	static vec set1(float f) { return _mm512_set1_ps(f); }
+	static vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+	static vec sub(vec a, vec b) { return _mm512_sub_ps(a, b); }
+	static vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+	static mask lt(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	static vec blend(unsigned bits, vec a, vec b) { return _mm512_mask_blend_ps(bits, a, b); }
+	static unsigned bits(mask m) { return m; }
+};
+template<> struct simd_traits<double> {
+	static constexpr int width = 8;
+	typedef __m512d vec;
+	typedef __mmask8 mask;
+	static vec load(const double* p) { return _mm512_loadu_pd(p); }
+	static void store(double* p, vec v) { _mm512_storeu_pd(p, v); }
+	static vec set1(double d) { return _mm512_set1_pd(d); }
+	static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+	static vec sub(vec a, vec b) { return _mm512_sub_pd(a, b); }
+	static vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+	static vec fma(vec a, vec b, vec c) { return _mm512_fmadd_pd(a, b, c); }
+	static vec fms(vec a, vec b, vec c) { return _mm512_fmsub_pd(a, b, c); }
+	static mask lt(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+	static vec blend(unsigned bits, vec a, vec b) { return _mm512_mask_blend_pd(bits, a, b); }
+	static unsigned bits(mask m) { return m; }
+};
+template<> struct simd_traits<Fixed64> {
+	static constexpr int width = 8;
+	typedef __m512i vec;
+	typedef __mmask8 mask;
+	static vec load(const Fixed64* p) { return _mm512_loadu_si512(p); }
+	static void store(Fixed64* p, vec v) { _mm512_storeu_si512(p, v); }
+	static vec set1(Fixed64 f) { return _mm512_set1_epi64(f.raw); }
+	static vec add(vec a, vec b) { return _mm512_add_epi64(a, b); }
+	static vec sub(vec a, vec b) { return _mm512_sub_epi64(a, b); }
+	static vec abs(vec a) { return _mm512_abs_epi64(a); }
+	//same truncated product of the magnitudes as Fixed64's operator*, put together from 32x32->64 bit products since there's no 64x64->128 bit one
+	static vec mul(vec a, vec b) {
+		const mask negative = _mm512_cmplt_epi64_mask(_mm512_xor_si512(a, b), _mm512_setzero_si512());
+		a = abs(a);
+		b = abs(b);
+		const vec a_hi = _mm512_srli_epi64(a, 32), b_hi = _mm512_srli_epi64(b, 32);
+		const vec middle = _mm512_add_epi64(_mm512_add_epi64(_mm512_mul_epu32(a, b_hi), _mm512_mul_epu32(a_hi, b)), _mm512_srli_epi64(_mm512_mul_epu32(a, b), 32));
+		const vec product = _mm512_add_epi64(_mm512_slli_epi64(_mm512_mul_epu32(a_hi, b_hi), 64 - Fixed64::FRACTION_BITS), _mm512_srli_epi64(middle, Fixed64::FRACTION_BITS - 32));
+		return _mm512_mask_sub_epi64(product, negative, _mm512_setzero_si512(), product);
+	}
+	static mask lt(vec a, vec b) { return _mm512_cmplt_epi64_mask(a, b); }
+	static vec blend(unsigned bits, vec a, vec b) { return _mm512_mask_blend_epi64(bits, a, b); }
+	static unsigned bits(mask m) { return m; }
+};
+#elif defined(KERNEL_AVX2)
+template<> struct simd_traits<float> {
+	static constexpr int width = 8;
+	typedef __m256 vec;
+	typedef __m256 mask;
+	static vec load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, vec v) { _mm256_storeu_ps(p, v); }
+	static vec set1(float f) { return _mm256_set1_ps(f); }
+	static vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+	static vec sub(vec a, vec b) { return _mm256_sub_ps(a, b); }
+	static vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+	static mask lt(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static vec blend(unsigned bits, vec a, vec b) {
+		const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		const __m256i m = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), lane_bits), lane_bits);
+		return _mm256_blendv_ps(a, b, _mm256_castsi256_ps(m));
+	}
+	static unsigned bits(mask m) { return _mm256_movemask_ps(m); }
+};
+template<> struct simd_traits<double> {
+	static constexpr int width = 4;
+	typedef __m256d vec;
+	typedef __m256d mask;
+	static vec load(const double* p) { return _mm256_loadu_pd(p); }
+	static void store(double* p, vec v) { _mm256_storeu_pd(p, v); }
+	static vec set1(double d) { return _mm256_set1_pd(d); }
+	static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+	static vec sub(vec a, vec b) { return _mm256_sub_pd(a, b); }
+	static vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+	static vec fma(vec a, vec b, vec c) { return _mm256_fmadd_pd(a, b, c); }
+	static vec fms(vec a, vec b, vec c) { return _mm256_fmsub_pd(a, b, c); }
+	static mask lt(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static vec blend(unsigned bits, vec a, vec b) {
+		const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+		const __m256i m = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lane_bits), lane_bits);
+		return _mm256_blendv_pd(a, b, _mm256_castsi256_pd(m));
+	}
+	static unsigned bits(mask m) { return _mm256_movemask_pd(m); }
+};
+template<> struct simd_traits<Fixed64> {
+	static constexpr int width = 4;
+	typedef __m256i vec;
+	typedef __m256i mask;
+	static vec load(const Fixed64* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(Fixed64* p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	static vec set1(Fixed64 f) { return _mm256_set1_epi64x(f.raw); }
+	static vec add(vec a, vec b) { return _mm256_add_epi64(a, b); }
+	static vec sub(vec a, vec b) { return _mm256_sub_epi64(a, b); }
+	static vec abs(vec a) {
+		const vec sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+		return _mm256_sub_epi64(_mm256_xor_si256(a, sign), sign);
+	}
+	//same truncated product of the magnitudes as Fixed64's operator*, put together from 32x32->64 bit products since there's no 64x64->128 bit one
+	static vec mul(vec a, vec b) {
+		const vec sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), _mm256_xor_si256(a, b));
+		a = abs(a);
+		b = abs(b);
+		const vec a_hi = _mm256_srli_epi64(a, 32), b_hi = _mm256_srli_epi64(b, 32);
+		const vec middle = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(a, b_hi), _mm256_mul_epu32(a_hi, b)), _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32));
+		const vec product = _mm256_add_epi64(_mm256_slli_epi64(_mm256_mul_epu32(a_hi, b_hi), 64 - Fixed64::FRACTION_BITS), _mm256_srli_epi64(middle, Fixed64::FRACTION_BITS - 32));
+		return _mm256_sub_epi64(_mm256_xor_si256(product, sign), sign);
+	}
+	static mask lt(vec a, vec b) { return _mm256_cmpgt_epi64(b, a); }
+	static vec blend(unsigned bits, vec a, vec b) {
+		const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+		const __m256i m = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lane_bits), lane_bits);
+		return _mm256_blendv_epi8(a, b, m);
+	}
+	static unsigned bits(mask m) { return _mm256_movemask_pd(_mm256_castsi256_pd(m)); }
+};
+#elif defined(__SSE2__)
+//SSE2 has no blendv, so blend() is and/andnot/or
+template<> struct simd_traits<float> {
+	static constexpr int width = 4;
+	typedef __m128 vec;
+	typedef __m128 mask;
+	static vec load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, vec v) { _mm_storeu_ps(p, v); }
+	static vec set1(float f) { return _mm_set1_ps(f); }
+	static vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+	static vec sub(vec a, vec b) { return _mm_sub_ps(a, b); }
+	static vec mul(vec a, vec b) { return _mm_mul_ps(a, b); }
+	static mask lt(vec a, vec b) { return _mm_cmplt_ps(a, b); }
+	static vec blend(unsigned bits, vec a, vec b) {
+		const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+		const __m128 m = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lane_bits), lane_bits));
+		return _mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, a));
+	}
+	static unsigned bits(mask m) { return _mm_movemask_ps(m); }
+};
+template<> struct simd_traits<double> {
+	static constexpr int width = 2;
+	typedef __m128d vec;
+	typedef __m128d mask;
+	static vec load(const double* p) { return _mm_loadu_pd(p); }
+	static void store(double* p, vec v) { _mm_storeu_pd(p, v); }
+	static vec set1(double d) { return _mm_set1_pd(d); }
+	static vec add(vec a, vec b) { return _mm_add_pd(a, b); }
+	static vec sub(vec a, vec b) { return _mm_sub_pd(a, b); }
+	static vec mul(vec a, vec b) { return _mm_mul_pd(a, b); }
+	static mask lt(vec a, vec b) { return _mm_cmplt_pd(a, b); }
+	static vec blend(unsigned bits, vec a, vec b) {
+		//no 64-bit compare in SSE2, but both halves of a lane compare the same
+		const __m128i lane_bits = _mm_setr_epi32(1, 1, 2, 2);
+		const __m128d m = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lane_bits), lane_bits));
+		return _mm_or_pd(_mm_and_pd(m, b), _mm_andnot_pd(m, a));
+	}
+	static unsigned bits(mask m) { return _mm_movemask_pd(m); }
+};
+#endif
+
+//double-double is a vector of hi parts and a vector of lo parts, doing the exact same operations as DoubleDouble's operators
+//(it needs FMA for the exact products; without it, double-double uses the scalar kernel)
+#if defined(KERNEL_AVX512) || defined(KERNEL_AVX2)
+template<> struct simd_traits<DoubleDouble> {
+	typedef simd_traits<double> base;
+	static constexpr int width = base::width;
+	struct vec { base::vec hi, lo; };
+	typedef unsigned mask; //comparing takes both parts, so it's easier as bits
+
+	static vec load(const DoubleDouble* p) {
+		double hi[width], lo[width];
+		for (int l = 0; l < width; l++) {
+			hi[l] = p[l].hi;
+			lo[l] = p[l].lo;
+		}
+		return { base::load(hi), base::load(lo) };
+	}
+	static void store(DoubleDouble* p, vec v) {
+		double hi[width], lo[width];
+		base::store(hi, v.hi);
+		base::store(lo, v.lo);
+		for (int l = 0; l < width; l++) {
+			p[l] = DoubleDouble(hi[l], lo[l]);
+		}
+	}
+	static vec set1(DoubleDouble d) { return { base::set1(d.hi), base::set1(d.lo) }; }
+
+	static vec twoSum(base::vec a, base::vec b) {
+		const base::vec s = base::add(a, b);
+		const base::vec b_part = base::sub(s, a);
+		return { s, base::add(base::sub(a, base::sub(s, b_part)), base::sub(b, b_part)) };
+	}
+	static vec quickTwoSum(base::vec a, base::vec b) {
+		const base::vec s = base::add(a, b);
+		return { s, base::sub(b, base::sub(s, a)) };
+	}
+	static vec add(vec a, vec b) {
+		const vec s = twoSum(a.hi, b.hi);
+		return quickTwoSum(s.hi, base::add(s.lo, base::add(a.lo, b.lo)));
+	}
+	static vec sub(vec a, vec b) {
+		const base::vec zero = base::set1(0);
+		return add(a, { base::sub(zero, b.hi), base::sub(zero, b.lo) });
+	}
+	static vec mul(vec a, vec b) {
+		const base::vec p = base::mul(a.hi, b.hi);
+		const base::vec error = base::fms(a.hi, b.hi, p);
+		return quickTwoSum(p, base::add(error, base::add(base::mul(a.hi, b.lo), base::mul(a.lo, b.hi))));
+	}
+
+	static mask lt(vec a, vec b) {
+		const unsigned hi_lt = base::bits(base::lt(a.hi, b.hi));
+		const unsigned hi_eq = ~hi_lt & ~base::bits(base::lt(b.hi, a.hi)) & ((1u << width) - 1);
+		return hi_lt | (hi_eq & base::bits(base::lt(a.lo, b.lo)));
+	}
+	static vec blend(unsigned bits, vec a, vec b) { return { base::blend(bits, a.hi, b.hi), base::blend(bits, a.lo, b.lo) }; }
+	static unsigned bits(mask m) { return m; }
+};
+#endif
+#endif
+
+//interleaved orbits: a plain array of independent scalar orbits standing in for a vector, for types (or instruction sets) without SIMD support
+//each z = z*z + c step has to wait for the previous one, so a single orbit leaves the FPU idle most of the time;
+//stepping several orbits side by side in one loop body gives it independent work to overlap (every operation is a short loop the compiler unrolls)
+//finished and inactive lanes keep getting stepped like the rest (on huge values, once they have escaped), so T's operators have to be defined for any value, like Fixed64's wrapping ones
+const int INTERLEAVED_ORBITS = 4;
+template<typename T, int N>
+struct Lanes {
+	T v[N];
+};
+template<typename T, int N> struct interleaved_traits {
+	static constexpr int width = N;
+	typedef Lanes<T, N> vec;
+	typedef unsigned mask;
+	static vec load(const T* p) {
+		vec r;
+		for (int l = 0; l < N; l++) r.v[l] = p[l];
+		return r;
+	}
+	static void store(T* p, vec v) {
+		for (int l = 0; l < N; l++) p[l] = v.v[l];
+	}
+	static vec set1(T t) {
+		vec r;
+		for (int l = 0; l < N; l++) r.v[l] = t;
+		return r;
+	}
+	static vec add(vec a, vec b) {
+		for (int l = 0; l < N; l++) a.v[l] = a.v[l] + b.v[l];
+		return a;
+	}
+	static vec sub(vec a, vec b) {
+		for (int l = 0; l < N; l++) a.v[l] = a.v[l] - b.v[l];
+		return a;
+	}
+	static vec mul(vec a, vec b) {
+		for (int l = 0; l < N; l++) a.v[l] = a.v[l] * b.v[l];
+		return a;
+	}
+	static mask lt(vec a, vec b) {
+		unsigned bits = 0;
+		for (int l = 0; l < N; l++) bits |= unsigned(a.v[l] < b.v[l]) << l;
+		return bits;
+	}
+	static vec blend(unsigned bits, vec a, vec b) {
+		for (int l = 0; l < N; l++) a.v[l] = ((bits >> l) & 1) ? b.v[l] : a.v[l];
+		return a;
+	}
+	static unsigned bits(mask m) { return m; }
+};
+
+//escape-time kernels:
+//all kernels do the exact same operations in the exact same order, so they produce identical iteration counts
+//(z*z is expanded by hand because the SIMD version can't use std::complex; that also lets x*x and y*y get reused for the escape check)
+
+//periodicity checking (Brent's method): z gets saved as a checkpoint after 1, 2, 4, 8, ... iterations, and if a later z lands back on it, the orbit is in a cycle and will never escape
+//the tolerance is a few ulps around |z|=1 for the type, squared because it's compared against dx*dx+dy*dy
+//(except for Fixed64, where dx*dx would get truncated to 0 long before dx is that small, so each part gets compared on its own instead)
+//(the first checkpoint is later than 1 so orbits that escape quickly never need one; it doesn't change which cycles get caught, just how soon)
+const int PERIODICITY_FIRST_CHECKPOINT = 16;
+template<typename T>
+constexpr T periodicity_tolerance() {
+	constexpr T eps = std::numeric_limits<T>::epsilon() * 4;
+	return eps*eps;
+}
+template<>
+constexpr DoubleDouble periodicity_tolerance<DoubleDouble>() {
+	return DoubleDouble(0x1p-204); //(2^-104 * 4)^2, since DoubleDouble's multiplication can't be constexpr
+}
+template<>
+constexpr Fixed64 periodicity_tolerance<Fixed64>() {
+	return Fixed64::fromRaw(4);
+}
+
+//whether an orbit is back within the tolerance of its checkpoint, dx and dy away from it
+template<typename T>
+inline bool near_checkpoint(T dx, T dy, T tolerance) {
+	return dx*dx + dy*dy < tolerance;
+}
+template<>
+inline bool near_checkpoint<Fixed64>(Fixed64 dx, Fixed64 dy, Fixed64 tolerance) {
+	//negating through Fixed64 wraps like the SIMD abs does (std::abs(INT64_MIN) is undefined, and wrapped-around orbits can get there)
+	const Fixed64 dx_magnitude = (dx.raw < 0) ? -dx : dx;
+	const Fixed64 dy_magnitude = (dy.raw < 0) ? -dy : dy;
+	return dx_magnitude < tolerance && dy_magnitude < tolerance;
+}
+
+//same for a vector of orbits, as bits
+template<typename T>
+inline unsigned near_checkpoint_lanes(typename simd_traits<T>::vec dx, typename simd_traits<T>::vec dy, typename simd_traits<T>::vec tolerance) {
+	typedef simd_traits<T> simd;
+	return simd::bits(simd::lt(simd::add(simd::mul(dx, dx), simd::mul(dy, dy)), tolerance));
+}
+#if defined(KERNEL_AVX512) || defined(KERNEL_AVX2)
+template<>
+inline unsigned near_checkpoint_lanes<Fixed64>(simd_traits<Fixed64>::vec dx, simd_traits<Fixed64>::vec dy, simd_traits<Fixed64>::vec tolerance) {
+	typedef simd_traits<Fixed64> simd;
+	return simd::bits(simd::lt(simd::abs(dx), tolerance)) & simd::bits(simd::lt(simd::abs(dy), tolerance));
+}
+#endif
+template<typename T, int N>
+inline unsigned near_checkpoint_lanes(Lanes<T, N> dx, Lanes<T, N> dy, Lanes<T, N> tolerance) {
+	unsigned bits = 0;
+	for (int l = 0; l < N; l++) bits |= unsigned(near_checkpoint(dx.v[l], dy.v[l], tolerance.v[l])) << l;
+	return bits;
+}
+
+//derivative check (DERIVATIVE_CHECK, on top of the periodicity check): dz, the derivative of z with respect to the last checkpoint, gets tracked too (d(z*z + c) = 2z*dz),
+//and an orbit that comes back near its checkpoint with |dz| < 1/2 has gone around something that shrinks everything nearby, i.e. an attracting cycle, which only exists inside the set
+//that happens long before the orbit converges to within a few ulps of the cycle, especially when the cycle only attracts slowly or in double or better
+//dz gets scaled down whenever it gets too big to keep it from overflowing; that only ever makes it smaller, but it has to shrink a lot on its own after that to matter
+const double DERIVATIVE_NEAR = 0x1p-20; //squared distance from the checkpoint
+const double DERIVATIVE_MAX = 0x1p-16; //squared |dz|, so |dz| < 1/256
+template<typename T>
+constexpr T derivative_cap() {
+	return T(0x1p64); //squared |dz|
+}
+template<typename T>
+constexpr T derivative_shrink() {
+	return T(0x1p-32);
+}
+//(Fixed64 only fits |dz| up to ~11, so it would have to get scaled down so often that it starts finding cycles that aren't there; main.cpp turns the check off for it)
+template<>
+constexpr Fixed64 derivative_cap<Fixed64>() {
+	return Fixed64(4);
+}
+template<>
+constexpr Fixed64 derivative_shrink<Fixed64>() {
+	return Fixed64(.25);
+}
+
+//an orbit that picks up at z = (x, y) after the given iterations (0 and 0 for a new one), and leaves x and y wherever it stopped;
+//running is whether that was MAX_ITER, as opposed to escaping or getting caught in a cycle
+//(picked up orbits start with a checkpoint where they pick up, and the next one twice as far in)
+template<typename T>
+inline int escape_time_orbit(T cx, T cy, T& x, T& y, int iterations, bool& running, KernelStats& stats) {
+	T check_x = x, check_y = y;
+	T dzx = 1, dzy = 0;
+	int check_at = std::max(PERIODICITY_FIRST_CHECKPOINT, 2 * iterations);
+	running = false;
+	while (iterations < MAX_ITER) {
+		const T xx = x*x;
+		const T yy = y*y;
+		if (!(xx + yy < 2*2)) {
+			break;
+		}
+		const T xy = x*y;
+		if (DERIVATIVE_CHECK) {
+			const T dzx_half = x*dzx - y*dzy;
+			const T dzy_half = x*dzy + y*dzx;
+			dzx = dzx_half + dzx_half;
+			dzy = dzy_half + dzy_half;
+		}
+		x = xx - yy + cx;
+		y = xy + xy + cy;
+		iterations++;
+
+		if (PERIODICITY_CHECK) {
+			const T dx = x - check_x;
+			const T dy = y - check_y;
+			if (near_checkpoint(dx, dy, periodicity_tolerance<T>())) {
+				stats.periodic++;
+				return MAX_ITER;
+			}
+			if (DERIVATIVE_CHECK) {
+				const T dz2 = dzx*dzx + dzy*dzy;
+				if (dz2 < T(DERIVATIVE_MAX) && dx*dx + dy*dy < T(DERIVATIVE_NEAR)) {
+					stats.derivative++;
+					return MAX_ITER;
+				}
+				if (!(dz2 < derivative_cap<T>())) {
+					dzx *= derivative_shrink<T>();
+					dzy *= derivative_shrink<T>();
+				}
+			}
+			if (iterations == check_at) {
+				check_x = x;
+				check_y = y;
+				dzx = 1;
+				dzy = 0;
+				check_at *= 2;
+			}
+		}
+	}
+	running = (iterations == MAX_ITER);
+	return iterations;
+}
+
+template<typename T>
+inline int escape_time_scalar(T cx, T cy, KernelStats& stats) {
+	T x = 0, y = 0;
+	bool running;
+	return escape_time_orbit(cx, cy, x, y, 0, running, stats);
+}
+
+//closed-form membership test for the two biggest components, which are most of the interior in wide views
+template<typename T>
+inline bool in_cardioid_or_bulb(T cx, T cy) {
+	const T yy = cy*cy;
+	const T q = (cx - T(.25))*(cx - T(.25)) + yy;
+	if (q*(q + (cx - T(.25))) <= yy*T(.25)) {
+		return true;
+	}
+	return (cx + 1)*(cx + 1) + yy <= T(1)/16;
+}
+
+template<typename T>
+inline int escape_time_pixel(T cx, T cy, KernelStats& stats) {
+	if (CARDIOID_CHECK && in_cardioid_or_bulb(cx, cy)) {
+		stats.cardioid++;
+		return MAX_ITER;
+	}
+	return escape_time_scalar(cx, cy, stats);
+}
+
+template<typename T, typename Pixels, typename Count>
+void escape_time_scalar_pixels(Pixels pixels, Count* iterations_arr, KernelStats& stats) {
+	const int count = pixels.size();
+	for (int i = 0; i < count; i++) {
+		T cx, cy;
+		pixels.next(cx, cy);
+		if constexpr (carries_orbits<Pixels>) {
+			bool running = false;
+			if (CARDIOID_CHECK && in_cardioid_or_bulb(cx, cy)) {
+				iterations_arr[i] = MAX_ITER;
+				stats.cardioid++;
+			} else {
+				iterations_arr[i] = escape_time_orbit(cx, cy, pixels.zx_arr[i], pixels.zy_arr[i], pixels.start_iterations, running, stats);
+			}
+			pixels.running_arr[i] = running;
+		} else {
+			iterations_arr[i] = escape_time_pixel(cx, cy, stats);
+		}
+	}
+}
+
+//escape_time_scalar()'s derivative check for a vector of orbits: derivative_step() updates dz from z before the step,
+//and derivative_interior() returns the lanes found interior (from the distance to the checkpoint after it) as bits, then keeps dz from overflowing
+template<typename T, typename simd>
+inline void derivative_step(typename simd::vec x, typename simd::vec y, typename simd::vec& dzx, typename simd::vec& dzy) {
+	const typename simd::vec dzx_half = simd::sub(simd::mul(x, dzx), simd::mul(y, dzy));
+	const typename simd::vec dzy_half = simd::add(simd::mul(x, dzy), simd::mul(y, dzx));
+	dzx = simd::add(dzx_half, dzx_half);
+	dzy = simd::add(dzy_half, dzy_half);
+}
+template<typename T, typename simd>
+inline unsigned derivative_interior(typename simd::vec dx, typename simd::vec dy, typename simd::vec& dzx, typename simd::vec& dzy) {
+	const typename simd::vec dz2 = simd::add(simd::mul(dzx, dzx), simd::mul(dzy, dzy));
+	const unsigned interior = simd::bits(simd::lt(dz2, simd::set1(T(DERIVATIVE_MAX))))
+		& simd::bits(simd::lt(simd::add(simd::mul(dx, dx), simd::mul(dy, dy)), simd::set1(T(DERIVATIVE_NEAR))));
+	const unsigned too_big = ~simd::bits(simd::lt(dz2, simd::set1(derivative_cap<T>()))) & ((1u << simd::width) - 1);
+	if (too_big) [[unlikely]] {
+		dzx = simd::blend(too_big, dzx, simd::mul(dzx, simd::set1(derivative_shrink<T>())));
+		dzy = simd::blend(too_big, dzy, simd::mul(dzy, simd::set1(derivative_shrink<T>())));
+	}
+	return interior;
+}
+
+template<typename T, typename simd = simd_traits<T>, typename Pixels, typename Count>
+void escape_time_refill_simd(Pixels pixels, Count* iterations_arr, KernelStats& stats);
+
+//escape_time_refill_simd() on interleaved scalar orbits
+template<typename T, typename Pixels, typename Count>
+void escape_time_interleaved(Pixels pixels, Count* iterations_arr, KernelStats& stats) {
+	if constexpr (std::is_same_v<T, long double>) {
+		//x87's 8 registers only hold one orbit, so interleaving just spills them all to memory, which is ~2.5x slower than the scalar kernel
+		escape_time_scalar_pixels<T>(pixels, iterations_arr, stats);
+	} else {
+		escape_time_refill_simd<T, interleaved_traits<T, INTERLEAVED_ORBITS>>(pixels, iterations_arr, stats);
+	}
+}
+
+//iterates pixels simd::width at a time; every lane steps in lockstep, so a lane's iteration count is simply the step it escaped on
+template<typename T, typename Pixels, typename Count>
+void escape_time_lockstep_simd(Pixels pixels, Count* iterations_arr, KernelStats& stats) {
+	typedef simd_traits<T> simd;
+	constexpr int W = simd::width;
+	if constexpr (W == 1) {
+		escape_time_interleaved<T>(pixels, iterations_arr, stats);
+	} else {
+		const int count = pixels.size();
+		for (int i = 0; i < count; i += W) {
+			const int lanes = std::min(W, count - i);
+
+			//pad the last vector with copies of a real pixel; their results get thrown away
+			T cx_lanes[W], cy_lanes[W];
+			int lane_iterations[W];
+			unsigned active = (1u << W) - 1;
+			for (int l = 0; l < W; l++) {
+				if (l < lanes) {
+					pixels.next(cx_lanes[l], cy_lanes[l]);
+				} else {
+					cx_lanes[l] = cx_lanes[l-1];
+					cy_lanes[l] = cy_lanes[l-1];
+				}
+				lane_iterations[l] = MAX_ITER;
+				if (CARDIOID_CHECK && in_cardioid_or_bulb(cx_lanes[l], cy_lanes[l])) {
+					active &= ~(1u << l);
+					stats.cardioid += (l < lanes);
+				}
+			}
+			if (!active) {
+				for (int l = 0; l < lanes; l++) {
+					iterations_arr[i + l] = MAX_ITER;
+				}
+				continue;
+			}
+			const unsigned iterated_lanes = active & ((1u << lanes) - 1); //lanes that actually get iterated, padding left out
+
+			const typename simd::vec cx = simd::load(cx_lanes);
+			const typename simd::vec cy = simd::load(cy_lanes);
+			const typename simd::vec escape = simd::set1(2*2);
+			const typename simd::vec tolerance = simd::set1(periodicity_tolerance<T>());
+			typename simd::vec x = simd::set1(0);
+			typename simd::vec y = simd::set1(0);
+			typename simd::vec check_x = simd::set1(0);
+			typename simd::vec check_y = simd::set1(0);
+			typename simd::vec dzx = simd::set1(1);
+			typename simd::vec dzy = simd::set1(0);
+			int check_at = PERIODICITY_FIRST_CHECKPOINT;
+
+			int iterations = 0;
+			while (iterations < MAX_ITER) {
+				const typename simd::vec xx = simd::mul(x, x);
+				const typename simd::vec yy = simd::mul(y, y);
+				const unsigned escaped = active & ~simd::bits(simd::lt(simd::add(xx, yy), escape));
+				if (escaped) [[unlikely]] {
+					for (int l = 0; l < W; l++) {
+						if (escaped & (1u << l)) {
+							lane_iterations[l] = iterations;
+						}
+					}
+					active &= ~escaped;
+					if (!active) {
+						break;
+					}
+				}
+				//escaped lanes keep going (possibly to inf/NaN), but they're no longer looked at
+				const typename simd::vec xy = simd::mul(x, y);
+				if (DERIVATIVE_CHECK) {
+					derivative_step<T, simd>(x, y, dzx, dzy);
+				}
+				x = simd::add(simd::sub(xx, yy), cx);
+				y = simd::add(simd::add(xy, xy), cy);
+				iterations++;
+
+				if (PERIODICITY_CHECK) {
+					const typename simd::vec dx = simd::sub(x, check_x);
+					const typename simd::vec dy = simd::sub(y, check_y);
+					const unsigned periodic = active & near_checkpoint_lanes<T>(dx, dy, tolerance);
+					const unsigned interior = DERIVATIVE_CHECK ? active & ~periodic & derivative_interior<T, simd>(dx, dy, dzx, dzy) : 0;
+					if (periodic | interior) [[unlikely]] {
+						//lane_iterations is already MAX_ITER
+						for (int l = 0; l < lanes; l++) {
+							stats.periodic += (periodic >> l) & 1;
+							stats.derivative += (interior >> l) & 1;
+						}
+						active &= ~(periodic | interior);
+						if (!active) {
+							break;
+						}
+					}
+					if (iterations == check_at) {
+						check_x = x;
+						check_y = y;
+						dzx = simd::set1(1);
+						dzy = simd::set1(0);
+						check_at *= 2;
+					}
+				}
+			}
+
+			for (int l = 0; l < lanes; l++) {
+				iterations_arr[i + l] = lane_iterations[l];
+			}
+			for (int l = 0; l < W; l++) {
+				if (iterated_lanes & (1u << l)) {
+					stats.used += (lane_iterations[l] == MAX_ITER) ? iterations : lane_iterations[l];
+				}
+			}
+			stats.total += uint64_t(iterations) * W;
+		}
+	}
+}
+
+//like escape_time_lockstep_simd(), except a lane gets the next pending pixel as soon as its current one finishes, instead of idling until the slowest lane is done
+//lanes track the step they were loaded on, so a lane's iteration count is how long it's been running
+//(simd is normally simd_traits<T>, or interleaved_traits for the interleaved kernel, which is also what types without SIMD support fall back to)
+template<typename T, typename simd, typename Pixels, typename Count>
+void escape_time_refill_simd(Pixels pixels, Count* iterations_arr, KernelStats& stats) {
+	constexpr int W = simd::width;
+	if constexpr (W == 1) {
+		escape_time_interleaved<T>(pixels, iterations_arr, stats);
+	} else {
+		//per-lane bookkeeping; the orbits themselves only live in the vectors (zx_lanes and zy_lanes are only where the new ones start)
+		T cx_lanes[W], cy_lanes[W];
+		T zx_lanes[W], zy_lanes[W];
+		int lane_pixel[W];
+		int lane_check_at[W];
+		int64_t lane_start[W];
+		const int pixel_count = pixels.size();
+		int next_pixel = 0;
+		unsigned active = 0;
+		int64_t step = 0;
+		int start_iterations = 0; //how far in pixels pick up their orbits
+		if constexpr (carries_orbits<Pixels>) {
+			start_iterations = pixels.start_iterations;
+		}
+
+		//loads pending pixels into the lanes in the "refill" mask; lanes that can't get one are deactivated
+		auto refill = [&](unsigned refill) {
+			for (; refill; refill &= refill - 1) {
+				const int l = __builtin_ctz(refill);
+				bool loaded = false;
+				while (next_pixel < pixel_count && !loaded) {
+					pixels.next(cx_lanes[l], cy_lanes[l]);
+					if constexpr (carries_orbits<Pixels>) {
+						zx_lanes[l] = pixels.zx_arr[next_pixel];
+						zy_lanes[l] = pixels.zy_arr[next_pixel];
+						pixels.running_arr[next_pixel] = 0;
+					} else {
+						zx_lanes[l] = 0;
+						zy_lanes[l] = 0;
+					}
+					if (CARDIOID_CHECK && in_cardioid_or_bulb(cx_lanes[l], cy_lanes[l])) {
+						iterations_arr[next_pixel] = MAX_ITER;
+						stats.cardioid++;
+					} else {
+						lane_pixel[l] = next_pixel;
+						lane_start[l] = step - start_iterations;
+						lane_check_at[l] = std::max(PERIODICITY_FIRST_CHECKPOINT, 2 * start_iterations);
+						loaded = true;
+					}
+					next_pixel++;
+				}
+				if (!loaded) {
+					active &= ~(1u << l);
+				}
+			}
+		};
+
+		//the next step where some lane reaches MAX_ITER or needs a new checkpoint, so the hot loop only has to compare one number
+		auto next_event = [&]() {
+			int64_t event = std::numeric_limits<int64_t>::max();
+			for (unsigned lanes = active; lanes; lanes &= lanes - 1) {
+				const int l = __builtin_ctz(lanes);
+				event = std::min(event, lane_start[l] + (PERIODICITY_CHECK ? std::min(MAX_ITER, lane_check_at[l]) : MAX_ITER));
+			}
+			return event;
+		};
+
+		active = (1u << W) - 1;
+		refill(active);
+		const typename simd::vec zero = simd::set1(0);
+		typename simd::vec x = simd::load(zx_lanes);
+		typename simd::vec y = simd::load(zy_lanes);
+		typename simd::vec cx = simd::load(cx_lanes);
+		typename simd::vec cy = simd::load(cy_lanes);
+		typename simd::vec check_x = x;
+		typename simd::vec check_y = y;
+		const typename simd::vec one = simd::set1(1);
+		typename simd::vec dzx = one;
+		typename simd::vec dzy = zero;
+		const typename simd::vec escape = simd::set1(2*2);
+		const typename simd::vec tolerance = simd::set1(periodicity_tolerance<T>());
+		int64_t event = next_event();
+		unsigned periodic = 0; //lanes that landed on their checkpoint last step
+		unsigned interior = 0; //lanes the derivative check caught last step
+
+		while (active) {
+			const typename simd::vec xx = simd::mul(x, x);
+			const typename simd::vec yy = simd::mul(y, y);
+			const unsigned escaped = active & ~simd::bits(simd::lt(simd::add(xx, yy), escape));
+
+			if (escaped || (periodic | interior) || step == event) [[unlikely]] {
+				unsigned finished = 0;
+				unsigned checkpoint = 0;
+				const bool all_lanes = (step == event);
+				T x_lanes[W], y_lanes[W]; //only stored once a lane needs its orbit saved
+				bool stored = false;
+				for (unsigned lanes = all_lanes ? active : (escaped | periodic | interior); lanes; lanes &= lanes - 1) {
+					const int l = __builtin_ctz(lanes);
+					//same priority as the scalar kernel: a cycle or MAX_ITER wins over escaping
+					const int iterations = int(step - lane_start[l]);
+					if ((periodic | interior) & (1u << l)) {
+						iterations_arr[lane_pixel[l]] = MAX_ITER;
+						stats.periodic += (periodic >> l) & 1;
+						stats.derivative += (interior >> l) & 1;
+					} else if (iterations == MAX_ITER) {
+						iterations_arr[lane_pixel[l]] = MAX_ITER;
+						if constexpr (carries_orbits<Pixels>) {
+							if (!stored) {
+								simd::store(x_lanes, x);
+								simd::store(y_lanes, y);
+								stored = true;
+							}
+							pixels.zx_arr[lane_pixel[l]] = x_lanes[l];
+							pixels.zy_arr[lane_pixel[l]] = y_lanes[l];
+							pixels.running_arr[lane_pixel[l]] = 1;
+						}
+					} else if (escaped & (1u << l)) {
+						iterations_arr[lane_pixel[l]] = iterations;
+					} else {
+						if (PERIODICITY_CHECK && iterations == lane_check_at[l]) {
+							checkpoint |= (1u << l);
+							lane_check_at[l] *= 2;
+						}
+						continue;
+					}
+					stats.used += iterations - start_iterations;
+					finished |= (1u << l);
+				}
+				periodic = 0;
+				interior = 0;
+				if (checkpoint) {
+					check_x = simd::blend(checkpoint, check_x, x);
+					check_y = simd::blend(checkpoint, check_y, y);
+					dzx = simd::blend(checkpoint, dzx, one);
+					dzy = simd::blend(checkpoint, dzy, zero);
+				}
+
+				if (finished) {
+					//new pixels start at z=0 (or wherever their orbit picks up) with their first checkpoint also there
+					refill(finished);
+					x = simd::blend(finished, x, simd::load(zx_lanes));
+					y = simd::blend(finished, y, simd::load(zy_lanes));
+					check_x = simd::blend(finished, check_x, x);
+					check_y = simd::blend(finished, check_y, y);
+					dzx = simd::blend(finished, dzx, one);
+					dzy = simd::blend(finished, dzy, zero);
+					cx = simd::load(cx_lanes);
+					cy = simd::load(cy_lanes);
+				}
+				if (all_lanes || finished) {
+					event = next_event();
+				}
+				if (finished) {
+					continue; //redo this step so the new pixels get their escape check
+				}
+			}
+
+			const typename simd::vec xy = simd::mul(x, y);
+			if (DERIVATIVE_CHECK) {
+				derivative_step<T, simd>(x, y, dzx, dzy);
+			}
+			x = simd::add(simd::sub(xx, yy), cx);
+			y = simd::add(simd::add(xy, xy), cy);
+			step++;
+
+			if (PERIODICITY_CHECK) {
+				const typename simd::vec dx = simd::sub(x, check_x);
+				const typename simd::vec dy = simd::sub(y, check_y);
+				periodic = active & near_checkpoint_lanes<T>(dx, dy, tolerance);
+				if (DERIVATIVE_CHECK) {
+					interior = active & ~periodic & derivative_interior<T, simd>(dx, dy, dzx, dzy);
+				}
+			}
+		}
+		stats.total += uint64_t(step) * W;
+	}
+}
+
+//returns the iteration count, and sets glitch_size to |z|^2 at the point the pixel glitched (or -1 if it didn't)
+template<typename T>
+inline int perturbation_scalar(T dcx, T dcy, const ReferenceOrbit& reference, T& glitch_size, KernelStats& stats) {
+	T dx = 0, dy = 0;
+	glitch_size = -1;
+	for (int n = 0; ; n++) {
+		const T x = reference.x[n] + dx;
+		const T y = reference.y[n] + dy;
+		const T size = x*x + y*y;
+		if (!(size < 2*2) || n == MAX_ITER) {
+			return n;
+		}
+		if (size < reference.glitch_below[n] || n == reference.length()) {
+			glitch_size = size;
+			return n;
+		}
+		const T dz2 = dx*dx + dy*dy;
+		int level = 0;
+		while (const BlaStep* next = reference.bla.step(n, level + 1)) {
+			if (!(dz2 < next->radius2)) {
+				break;
+			}
+			level++;
+		}
+		if (level > 0) {
+			const BlaStep& step = reference.bla.levels[level][n >> level];
+			const T new_dx = (step.ax*dx - step.ay*dy) + (step.bx*dcx - step.by*dcy);
+			dy = (step.ax*dy + step.ay*dx) + (step.bx*dcy + step.by*dcx);
+			dx = new_dx;
+			n += (1 << level) - 1;
+			stats.skipped += (1 << level) - 1;
+			continue;
+		}
+		const T tx = (reference.x[n] + reference.x[n]) + dx;
+		const T ty = (reference.y[n] + reference.y[n]) + dy;
+		const T new_dx = (tx*dx - ty*dy) + dcx;
+		dy = (tx*dy + ty*dx) + dcy;
+		dx = new_dx;
+	}
+}
+
+//same as perturbation_scalar() for count pixels, simd::width at a time
+//every lane is at the same step of the reference orbit, so its values just get broadcast
+template<typename T>
+void perturbation_kernel(const T* dcx_arr, const T* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, T* glitch_size, KernelStats& stats) {
+	typedef simd_traits<T> simd;
+	constexpr int W = simd::width;
+	if (W == 1 || KERNEL_TYPE == KernelType::scalar) {
+		for (int i = 0; i < count; i++) {
+			iterations_arr[i] = perturbation_scalar(dcx_arr[i], dcy_arr[i], reference, glitch_size[i], stats);
+		}
+		return;
+	}
+	if constexpr (W > 1) {
+		const int length = reference.length();
+		for (int i = 0; i < count; i += W) {
+			const int lanes = std::min(W, count - i);
+
+			//pad the last vector with copies of a real pixel; their results get thrown away
+			T dcx_lanes[W], dcy_lanes[W], size_lanes[W];
+			int lane_iterations[W];
+			T lane_glitch[W];
+			for (int l = 0; l < W; l++) {
+				dcx_lanes[l] = dcx_arr[i + std::min(l, lanes-1)];
+				dcy_lanes[l] = dcy_arr[i + std::min(l, lanes-1)];
+				lane_glitch[l] = -1;
+			}
+			unsigned active = (1u << W) - 1;
+
+			const typename simd::vec dcx = simd::load(dcx_lanes);
+			const typename simd::vec dcy = simd::load(dcy_lanes);
+			const typename simd::vec escape = simd::set1(2*2);
+			typename simd::vec dx = simd::set1(0);
+			typename simd::vec dy = simd::set1(0);
+
+			int n = 0;
+			while (true) {
+				const typename simd::vec zx = simd::set1(reference.x[n]);
+				const typename simd::vec zy = simd::set1(reference.y[n]);
+				const typename simd::vec x = simd::add(zx, dx);
+				const typename simd::vec y = simd::add(zy, dy);
+				const typename simd::vec size = simd::add(simd::mul(x, x), simd::mul(y, y));
+
+				const unsigned done = (n == MAX_ITER) ? active : active & ~simd::bits(simd::lt(size, escape));
+				const unsigned glitched = (n == length) ? active & ~done : active & ~done & simd::bits(simd::lt(size, simd::set1(reference.glitch_below[n])));
+				if (done | glitched) [[unlikely]] {
+					simd::store(size_lanes, size);
+					for (int l = 0; l < W; l++) {
+						if ((done | glitched) & (1u << l)) {
+							lane_iterations[l] = n;
+						}
+						if (glitched & (1u << l)) {
+							lane_glitch[l] = size_lanes[l];
+						}
+					}
+					active &= ~(done | glitched);
+					if (!active) {
+						break;
+					}
+				}
+
+				//a BLA step has to be valid for every lane that's still going
+				if ((n & 1) == 0 && !reference.bla.levels.empty()) {
+					const typename simd::vec dz2 = simd::add(simd::mul(dx, dx), simd::mul(dy, dy));
+					int level = 0;
+					while (const BlaStep* next = reference.bla.step(n, level + 1)) {
+						if ((simd::bits(simd::lt(dz2, simd::set1(next->radius2))) & active) != active) {
+							break;
+						}
+						level++;
+					}
+					if (level > 0) {
+						const BlaStep& step = reference.bla.levels[level][n >> level];
+						const typename simd::vec ax = simd::set1(step.ax), ay = simd::set1(step.ay);
+						const typename simd::vec bx = simd::set1(step.bx), by = simd::set1(step.by);
+						const typename simd::vec new_dx = simd::add(simd::sub(simd::mul(ax, dx), simd::mul(ay, dy)), simd::sub(simd::mul(bx, dcx), simd::mul(by, dcy)));
+						dy = simd::add(simd::add(simd::mul(ax, dy), simd::mul(ay, dx)), simd::add(simd::mul(bx, dcy), simd::mul(by, dcx)));
+						dx = new_dx;
+						n += 1 << level;
+						stats.skipped += uint64_t((1 << level) - 1) * std::popcount(active & ((1u << lanes) - 1)); //padding left out
+						continue;
+					}
+				}
+
+				const typename simd::vec tx = simd::add(simd::add(zx, zx), dx);
+				const typename simd::vec ty = simd::add(simd::add(zy, zy), dy);
+				const typename simd::vec new_dx = simd::add(simd::sub(simd::mul(tx, dx), simd::mul(ty, dy)), dcx);
+				dy = simd::add(simd::add(simd::mul(tx, dy), simd::mul(ty, dx)), dcy);
+				dx = new_dx;
+				n++;
+			}
+
+			for (int l = 0; l < lanes; l++) {
+				iterations_arr[i + l] = lane_iterations[l];
+				glitch_size[i + l] = lane_glitch[l];
+				stats.used += lane_iterations[l];
+			}
+			stats.total += uint64_t(n) * W;
+		}
+	}
+}
+
+//runs whichever --kernel was picked
+template<typename T, typename Pixels, typename Count>
+void run_kernel(Pixels pixels, Count* iterations_arr, KernelStats& stats) {
+	switch (KERNEL_TYPE) {
+		case KernelType::refill:
+			escape_time_refill_simd<T>(pixels, iterations_arr, stats);
+			break;
+		case KernelType::simd:
+			if constexpr (carries_orbits<Pixels>) {
+				escape_time_refill_simd<T>(pixels, iterations_arr, stats); //lanes in lockstep can't pick up orbits at different points
+			} else {
+				escape_time_lockstep_simd<T>(pixels, iterations_arr, stats);
+			}
+			break;
+		case KernelType::interleaved:
+			escape_time_interleaved<T>(pixels, iterations_arr, stats);
+			break;
+		case KernelType::scalar:
+			escape_time_scalar_pixels<T>(pixels, iterations_arr, stats);
+			break;
+	}
+}
+
+//everything main.cpp calls, for both widths of iteration counts
+#define INSTANTIATE_KERNELS(T, Count) \
+	template void run_kernel<T, GridPixels<T>, Count>(GridPixels<T> pixels, Count* iterations_arr, KernelStats& stats); \
+	template void run_kernel<T, ListPixels<T>, Count>(ListPixels<T> pixels, Count* iterations_arr, KernelStats& stats); \
+	template void run_kernel<T, OrbitPixels<T>, Count>(OrbitPixels<T> pixels, Count* iterations_arr, KernelStats& stats);
+#define INSTANTIATE_KERNELS_BOTH(T) INSTANTIATE_KERNELS(T, uint16_t) INSTANTIATE_KERNELS(T, uint32_t)
+INSTANTIATE_KERNELS_BOTH(float)
+INSTANTIATE_KERNELS_BOTH(double)
+INSTANTIATE_KERNELS_BOTH(long double)
+INSTANTIATE_KERNELS_BOTH(DoubleDouble)
+INSTANTIATE_KERNELS_BOTH(Fixed64)
+#undef INSTANTIATE_KERNELS_BOTH
+#undef INSTANTIATE_KERNELS
+template void perturbation_kernel<double>(const double* dcx_arr, const double* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, double* glitch_size, KernelStats& stats);
+
+}
+
+#if defined(KERNEL_TARGET)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,3 @@
+//the kernels for any x86-64 CPU (float and double get SSE2, everything else is scalar)
+#define KERNEL_NAMESPACE isa_sse2
+#include "kernels_impl.h"
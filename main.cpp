@@ -7,6 +7,19 @@
 #include <vector>
 #include <cstdint> //to be fancy with uint8_t vs uint16_t
 #include <limits> //for <cstdint>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <numeric> //std::iota
+#include <cstring> //std::memcpy
+#include <sys/mman.h> //mapping iteration caches
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <cassert> //Magick++ makes its own assert (__assert_fail()), causes enkiTS to fail compilation
 #include <Magick++.h>
@@ -14,7 +27,10 @@
 #include "enkiTS/TaskScheduler.h"
 enki::TaskScheduler g_TS;
 
-typedef float c_float; //complex float precision
+#include "fixed_point.h"
+#include "double_double.h"
+#include "fixed64.h"
+#include "kernels.h"
 
 int MAX_ITER = 10000;
 std::vector<std::pair<int, Magick::ColorRGB>> iterationColors = {
@@ -34,12 +50,87 @@ std::vector<std::pair<int, Magick::ColorRGB>> iterationColors = {
 };
 //idea: option for linear interpolation for color boundaries
 
-void readColorFileAndSetColors(const std::string& filename) {
+//what the pixel coordinates get iterated in; automatic picks the cheapest one that can still tell neighboring pixels apart, mixed does that per tile,
+//and fixed (Fixed64) is integer math that comes out the same on every machine
+enum class Precision { automatic, float_, double_, long_double, double_double, mixed, fixed };
+Precision PRECISION = Precision::automatic;
+
+KernelType KERNEL_TYPE = KernelType::refill;
+
+SimdLevel SIMD_LEVEL; //which build of the kernels runs; the best one the CPU supports unless --simd says otherwise
+
+enum class RenderMode { brute, subdivide, boundary, guess };
+RenderMode RENDER_MODE = RenderMode::brute;
+
+//--mode=brute hands out TILE_SIZE x TILE_SIZE tiles along a space-filling curve, so every task's pixels are close together,
+//and an expensive area gets split between tasks instead of ending up in one run of rows; 0 hands out whole rows instead
+//cost hands them out most expensive first instead (going by a preview of every PREVIEW_STEP-th pixel), so the render doesn't end on one big tile
+int TILE_SIZE = 64;
+enum class TileOrder { hilbert, morton, cost };
+TileOrder TILE_ORDER = TileOrder::hilbert;
+const int PREVIEW_STEP = 8;
+
+bool CARDIOID_CHECK = true; //skip iterating pixels in the main cardioid or period-2 bulb
+bool PERIODICITY_CHECK = true; //stop iterating once the orbit is caught in a cycle
+bool SYMMETRY = true; //with --mode=brute, copy rows whose imaginary part is exactly the negative of another row's instead of computing them
+bool DERIVATIVE_CHECK = false; //with PERIODICITY_CHECK, also stop once the orbit's derivative shows an attracting cycle, long before it converges exactly
+bool VALIDATE = false; //compute every pixel again afterwards without any shortcuts, and count the ones that came out different
+bool PERTURBATION = false; //iterate pixels as offsets from a high-precision reference orbit, for deep zooms
+int REFERENCE_BITS = 0; //with PERTURBATION, the reference orbit's fraction bits (rounded up to 32), or 0 to go by the zoom
+bool BLA_SKIPPING = true; //with PERTURBATION, skip stretches of the reference orbit where the offsets are nearly linear
+bool AUTO_MAX_ITER = false; //pick MAX_ITER from a sample of the view instead of the coloring file, and stretch the colorings to match
+
+std::string SAVE_ITERATIONS_FILE = ""; //where to save the iteration counts for recoloring later, if anywhere
+std::string SAVE_ORBITS_FILE = ""; //where to save the iteration counts plus where the pixels that ran out of iterations left off, if anywhere
+std::string RESUME_ORBITS_FILE = ""; //a --save-orbits file to pick up from with a higher MAX_ITER instead of starting over, if any
+std::string RECOLOR_FILE = ""; //the iteration cache to color instead of computing anything
+
+//summed up from every thread's KernelStats
+std::atomic<uint64_t> usedLaneIterations = 0;
+std::atomic<uint64_t> totalLaneIterations = 0;
+std::atomic<uint64_t> cardioidPixels = 0;
+std::atomic<uint64_t> periodicPixels = 0;
+std::atomic<uint64_t> derivativePixels = 0;
+std::atomic<uint64_t> computedPixels = 0;
+std::atomic<uint64_t> glitchedPixels = 0;
+std::atomic<uint64_t> skippedIterations = 0;
+int mirroredRows = 0;
+
+//with --save-orbits or --resume-orbits, the pixels still running at MAX_ITER, as orbit file records (see saveOrbits())
+std::vector<uint8_t> orbitRecords;
+uint64_t runningPixels = 0;
+uint64_t resumedPixels = 0;
+int resumedFrom = 0; //the MAX_ITER they got picked up at
+
+//tile timings for the tail stats, in microseconds since tilesStartTime: once the last tile has started, there's nothing left to hand out,
+//so from then on threads can only run out of work
+std::chrono::time_point<std::chrono::steady_clock> tilesStartTime;
+std::atomic<int64_t> lastTileStart = 0;
+std::atomic<int64_t> lastTileEnd = 0;
+std::atomic<int64_t> longestTile = 0;
+std::atomic<int64_t> previewTime = 0;
+
+void atomicMax(std::atomic<int64_t>& max, int64_t value) {
+	int64_t current = max;
+	while (value > current && !max.compare_exchange_weak(current, value)) {}
+}
+
+void addKernelStats(const KernelStats& stats) {
+	usedLaneIterations += stats.used;
+	totalLaneIterations += stats.total;
+	cardioidPixels += stats.cardioid;
+	periodicPixels += stats.periodic;
+	derivativePixels += stats.derivative;
+	computedPixels += stats.pixels;
+	glitchedPixels += stats.glitched;
+	skippedIterations += stats.skipped;
+}
+
+std::vector<std::pair<int, Magick::ColorRGB>> readColorFile(const std::string& filename) {
+	std::vector<std::pair<int, Magick::ColorRGB>> colors;
 	std::ifstream coloringFile;
 	coloringFile.open(filename);
 	if (coloringFile.is_open()) {
-		iterationColors.clear();
-
 		std::string line;
 		int lineNum = 0;
 		while (std::getline(coloringFile, line)) {
@@ -92,190 +183,2405 @@ void readColorFileAndSetColors(const std::string& filename) {
 			b = std::stod(colorB);
 			//double because Magick::ColorRGB takes doubles
 
-			iterationColors.push_back({ iter, {r, g, b} });
+			colors.push_back({ iter, {r, g, b} });
 		}
-		if (iterationColors.empty()) [[unlikely]] {
+		if (colors.empty()) [[unlikely]] {
 			throw std::runtime_error("Syntax error: nothing in \"" + filename + "\"");
 		}
-		MAX_ITER = iterationColors[iterationColors.size()-1].first;
-
 		//handling the file not being sorted for some reason:
-		//std::stable_sort(iterationColors.begin(), iterationColors.end(),
+		//std::stable_sort(colors.begin(), colors.end(),
 		//	[](const std::pair<int, ColorRGB>& lhs, const std::pair<int, ColorRGB>& rhs) { return lhs.first < rhs.first; });
 		//should be stable to give priority coloring to later lines
 
-		iterationColors.shrink_to_fit();
+		colors.shrink_to_fit();
 		coloringFile.close();
+		return colors;
 	} else {
 		throw std::runtime_error("Could not open file \"" + filename + "\"");
 	}
 }
 
-struct MandelbrotTask : public enki::ITaskSet {
-	#ifdef USE_IM6
-	Magick::PixelPacket* pixel_arr;
-	MandelbrotTask(Magick::PixelPacket* pixels, c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_width, int image_height);
-	#else
-	Magick::Quantum* pixel_arr;
-	MandelbrotTask(Magick::Quantum* pixels, c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_width, int image_height);
-	#endif
+void readColorFileAndSetColors(const std::string& filename) {
+	iterationColors = readColorFile(filename);
+	MAX_ITER = iterationColors[iterationColors.size()-1].first;
+}
 
-	c_float x_start, x_end, y_start, y_end;
-	int image_width, image_height;
+//the best level of the kernels this CPU can run (only x86-64 has more than one)
+SimdLevel bestSimdLevel() {
+#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("x86-64-v4")) {
+		return SimdLevel::avx512;
+	} else if (__builtin_cpu_supports("x86-64-v3")) {
+		return SimdLevel::avx2;
+	}
+	return SimdLevel::sse2;
+#else
+	return SimdLevel::generic;
+#endif
+}
+
+const char* simdLevelName(SimdLevel level) {
+#if defined(__x86_64__)
+	switch (level) {
+		case SimdLevel::avx512: return "avx512";
+		case SimdLevel::avx2: return "avx2";
+		default: return "sse2";
+	}
+#else
+	return "generic";
+#endif
+}
+
+//perturbation, for deep zooms:
+//once pixels get closer together than even DoubleDouble can tell apart, only one reference point C gets iterated in high precision (FixedPoint)
+//every pixel then iterates its difference from the reference orbit Z instead: with z = Z + dz and c = C + dc, dz' = (2Z + dz)*dz + dc, which double handles fine since dz and dc are tiny
+//the pixel sources hand out offsets from the reference in pixel units, and only here do they get scaled to dc, so the zoom depth isn't limited by their type's exponent range
+//a pixel glitches when |z| gets much smaller than |Z| (dz then has no precision left relative to z) or when the reference escapes first;
+//glitched pixels get a new reference picked from among themselves and are redone, since a reference is always exact for its own pixel;
+//those references get shared, since neighboring tasks tend to glitch around the same features
+
+const double GLITCH_TOLERANCE = 1e-6; //glitched once |z|^2 < GLITCH_TOLERANCE*|Z|^2
+const int MAX_REFERENCES = 128; //per batch of pixels; anything still glitched after that keeps its iteration count from the last try
+const double REFERENCE_REUSE_DISTANCE = 32; //in pixels; a glitched pixel tries a shared reference this close before making its own
+
+//bilinear approximation (BLA): while dz is small enough next to Z that dz^2 doesn't matter, dz' = 2Z*dz + dc is linear in dz and dc,
+//so any stretch of iterations is just dz_(n+k) = A*dz_n + B*dc, with A and B only depending on the reference orbit
+//a step over 2^k iterations is made out of the two 2^(k-1) steps it covers, and is valid while |dz| stays below its radius
+const double BLA_EPSILON = 1.0 / (1ll << 53); //how small dz^2 has to be next to 2Z*dz to drop it
+
+
+struct DeepZoom {
+	FixedPoint center_x, center_y;
+	double pixel_width, pixel_height; //dc between neighboring pixels
+	double max_dc; //the farthest any pixel can be from any reference (the image's diagonal)
+	ReferenceOrbit reference; //for the center
+
+	//for glitched pixels; never removed from, so the orbits can be read without holding the mutex
+	std::mutex extraReferencesMutex;
+	std::vector<std::unique_ptr<ReferenceOrbit>> extraReferences;
+};
+DeepZoom deepZoom;
+
+//fills in one level of a BlaTable, in parallel since the center's table can have millions of steps
+struct BlaLevelTask : public enki::ITaskSet {
+	const ReferenceOrbit* reference;
+	BlaTable* table;
+	int level;
+	BlaLevelTask(const ReferenceOrbit* reference, BlaTable* table, int level);
 
 	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
 };
 
-#ifdef USE_IM6
-void mandelbrot_helper(c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, int image_height, Magick::PixelPacket* pixel_arr) {
+void BlaLevelTask::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	std::vector<BlaStep>& steps = table->levels[level];
+	for (uint32_t j = range_.start; j < range_.end; j++) {
+		if (level == 0) {
+			//one iteration: A = 2Z, B = 1, and dz^2 is negligible next to 2Z*dz while |dz| < BLA_EPSILON*|2Z|
+			const double ax = 2 * reference->x[j], ay = 2 * reference->y[j];
+			steps[j] = { ax, ay, 1, 0, BLA_EPSILON*BLA_EPSILON * (ax*ax + ay*ay) };
+			continue;
+		}
+		//first x, then y: A = Ay*Ax, B = Ay*Bx + By, and after x, |dz| grows to at most |Ax|*|dz| + |Bx|*max_dc which has to fit y's radius
+		const BlaStep& x = table->levels[level-1][2*j];
+		const BlaStep& y = table->levels[level-1][2*j + 1];
+		BlaStep& step = steps[j];
+		step.ax = y.ax*x.ax - y.ay*x.ay;
+		step.ay = y.ax*x.ay + y.ay*x.ax;
+		step.bx = (y.ax*x.bx - y.ay*x.by) + y.bx;
+		step.by = (y.ax*x.by + y.ay*x.bx) + y.by;
+		const double x_a = std::hypot(x.ax, x.ay);
+		const double y_radius = std::max(0.0, std::sqrt(y.radius2) - std::hypot(x.bx, x.by) * deepZoom.max_dc);
+		step.radius2 = (x_a > 0) ? std::min(x.radius2, (y_radius / x_a) * (y_radius / x_a)) : x.radius2;
+	}
+}
+
+BlaLevelTask::BlaLevelTask(const ReferenceOrbit* reference, BlaTable* table, int level) {
+	m_MinRange = 4096;
+	m_SetSize = table->levels[level].size();
+	this->reference = reference;
+	this->table = table;
+	this->level = level;
+}
+
+//the steps stop short of the end of the orbit, so the last iteration still gets checked for the reference escaping
+BlaTable buildBlaTable(const ReferenceOrbit& reference) {
+	BlaTable table;
+	for (int level = 0; (reference.length() >> level) > 0; level++) {
+		table.levels.emplace_back(reference.length() >> level);
+		BlaLevelTask task(&reference, &table, level);
+		g_TS.AddTaskSetToPipe(&task);
+		g_TS.WaitforTask(&task);
+	}
+	return table;
+}
+
+//the reference orbit squares instead of multiplying from this many fraction limbs; below it, the extra additions cost as much as squaring saves (see bench_fixed_point.cpp)
+const int ORBIT_SQUARING_LIMBS = 12;
+
+ReferenceOrbit computeReferenceOrbit(double dcx, double dcy) {
+	ReferenceOrbit orbit;
+	orbit.dcx = dcx;
+	orbit.dcy = dcy;
+	const int limbs = deepZoom.center_x.fractionLimbs();
+	const FixedPoint cx = deepZoom.center_x + FixedPoint::fromDouble(dcx, limbs);
+	const FixedPoint cy = deepZoom.center_y + FixedPoint::fromDouble(dcy, limbs);
+	FixedPoint x(limbs), y(limbs);
+	for (int n = 0; ; n++) {
+		const double zx = x.toDouble(), zy = y.toDouble();
+		orbit.x.push_back(zx);
+		orbit.y.push_back(zy);
+		orbit.glitch_below.push_back(GLITCH_TOLERANCE * (zx*zx + zy*zy));
+		if (!(zx*zx + zy*zy < 2*2) || n == MAX_ITER) {
+			break;
+		}
+		if (limbs < ORBIT_SQUARING_LIMBS) {
+			const FixedPoint xx = x*x, yy = y*y, xy = x*y;
+			x = xx - yy + cx;
+			y = xy + xy + cy;
+		} else {
+			//2xy = (x+y)^2 - x^2 - y^2, since squaring is cheaper than multiplying
+			const FixedPoint xx = x.square(), yy = y.square();
+			y = (x + y).square() - xx - yy + cy;
+			x = xx - yy + cx;
+		}
+	}
+	if (BLA_SKIPPING) {
+		orbit.bla = buildBlaTable(orbit);
+	}
+	return orbit;
+}
+
+//perturbation_kernel<double>() from whichever build of the kernels was picked
+void perturbation_kernel(const double* dcx_arr, const double* dcy_arr, int count, const ReferenceOrbit& reference, int* iterations_arr, double* glitch_size, KernelStats& stats) {
+#if defined(__x86_64__)
+	switch (SIMD_LEVEL) {
+		case SimdLevel::avx512:
+			isa_avx512::perturbation_kernel(dcx_arr, dcy_arr, count, reference, iterations_arr, glitch_size, stats);
+			break;
+		case SimdLevel::avx2:
+			isa_avx2::perturbation_kernel(dcx_arr, dcy_arr, count, reference, iterations_arr, glitch_size, stats);
+			break;
+		case SimdLevel::sse2:
+			isa_sse2::perturbation_kernel(dcx_arr, dcy_arr, count, reference, iterations_arr, glitch_size, stats);
+			break;
+	}
 #else
-void mandelbrot_helper(c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, int image_height, Magick::Quantum* pixel_arr) {
+	isa_generic::perturbation_kernel(dcx_arr, dcy_arr, count, reference, iterations_arr, glitch_size, stats);
 #endif
-	//flip y-range because images have the y-axis going down:
-	y_start *= -1;
-	y_end *= -1;
-	std::swap(y_start, y_end);
+}
 
-	//now actually do the calculation:
-	//std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
-	for (int y = image_y_start; y < image_y_end; y++) {
-		for (int x = image_x_start; x < image_x_end; x++) {
-			//using the center of the pixel
-			const c_float pointX = ((c_float(x)+c_float(.5)) * (x_end - x_start)) / (image_width)  + x_start;
-			const c_float pointY = ((c_float(y)+c_float(.5)) * (y_end - y_start)) / (image_height) + y_start;
-
-			int iterations = 0;
-			std::complex<c_float> z = std::complex<c_float>(0, 0);
-			std::complex<c_float> c = std::complex<c_float>(pointX, pointY);
-			while (std::norm(z) < 2*2 && iterations < MAX_ITER) {
-				z = z*z + c;
-				iterations++;
+//iterates every pixel against the center's reference orbit, then keeps picking new references for whatever glitched
+template<typename T, template<typename> typename Pixels, typename Count>
+void perturbation_pixels(Pixels<T> pixels, Count* iterations_arr, KernelStats& stats) {
+	const int count = pixels.size();
+	std::vector<double> dcx(count), dcy(count);
+	for (int i = 0; i < count; i++) {
+		T offset_x, offset_y;
+		pixels.next(offset_x, offset_y);
+		dcx[i] = double(offset_x) * deepZoom.pixel_width;
+		dcy[i] = double(offset_y) * deepZoom.pixel_height;
+	}
+
+	std::vector<int> pending(count);
+	for (int i = 0; i < count; i++) {
+		pending[i] = i;
+	}
+	const ReferenceOrbit* reference = &deepZoom.reference;
+	std::vector<const ReferenceOrbit*> tried = { reference };
+
+	std::vector<double> pending_dcx, pending_dcy, glitch_size;
+	std::vector<int> results;
+	for (int references = 1; ; references++) {
+		const int pending_count = pending.size();
+		pending_dcx.resize(pending_count);
+		pending_dcy.resize(pending_count);
+		glitch_size.resize(pending_count);
+		results.resize(pending_count);
+		for (int i = 0; i < pending_count; i++) {
+			pending_dcx[i] = dcx[pending[i]] - reference->dcx;
+			pending_dcy[i] = dcy[pending[i]] - reference->dcy;
+		}
+		perturbation_kernel(pending_dcx.data(), pending_dcy.data(), pending_count, *reference, results.data(), glitch_size.data(), stats);
+
+		std::vector<int> glitched;
+		int closest = -1; //the glitched pixel that got closest to 0 is the most likely to be near whatever the old reference missed
+		for (int i = 0; i < pending_count; i++) {
+			iterations_arr[pending[i]] = results[i];
+			if (glitch_size[i] >= 0) {
+				if (closest < 0 || glitch_size[i] < glitch_size[closest]) {
+					closest = i;
+				}
+				glitched.push_back(pending[i]);
 			}
+		}
+		if (glitched.empty()) {
+			break;
+		}
+		if (references == MAX_REFERENCES) {
+			stats.glitched += glitched.size();
+			break;
+		}
 
-			//color lookup
-			int colorIndex = 0;
-			for (int i = 1; i < iterationColors.size(); i++) {
-				if (iterations >= iterationColors[i].first) {
-					colorIndex = i;
-				} else {
-					break;
+		const double closest_dcx = dcx[pending[closest]];
+		const double closest_dcy = dcy[pending[closest]];
+		reference = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(deepZoom.extraReferencesMutex);
+			double best_distance = REFERENCE_REUSE_DISTANCE;
+			for (const std::unique_ptr<ReferenceOrbit>& extra : deepZoom.extraReferences) {
+				const double distance = std::hypot((extra->dcx - closest_dcx) / deepZoom.pixel_width, (extra->dcy - closest_dcy) / deepZoom.pixel_height);
+				if (distance <= best_distance && std::find(tried.begin(), tried.end(), extra.get()) == tried.end()) {
+					best_distance = distance;
+					reference = extra.get();
 				}
 			}
+		}
+		if (!reference) {
+			std::unique_ptr<ReferenceOrbit> extra = std::make_unique<ReferenceOrbit>(computeReferenceOrbit(closest_dcx, closest_dcy));
+			reference = extra.get();
+			std::lock_guard<std::mutex> lock(deepZoom.extraReferencesMutex);
+			deepZoom.extraReferences.push_back(std::move(extra));
+		}
+		tried.push_back(reference);
+		pending.swap(glitched);
+	}
+}
+
+//runs whichever kernel was picked, from whichever build of the kernels was picked
+template<typename T, template<typename> typename Pixels, typename Count>
+void compute_pixels(Pixels<T> pixels, Count* iterations_arr, KernelStats& stats) {
+	if (PERTURBATION) {
+		perturbation_pixels(pixels, iterations_arr, stats);
+		stats.pixels += pixels.size();
+		return;
+	}
+#if defined(__x86_64__)
+	switch (SIMD_LEVEL) {
+		case SimdLevel::avx512:
+			isa_avx512::run_kernel<T>(pixels, iterations_arr, stats);
+			break;
+		case SimdLevel::avx2:
+			isa_avx2::run_kernel<T>(pixels, iterations_arr, stats);
+			break;
+		case SimdLevel::sse2:
+			isa_sse2::run_kernel<T>(pixels, iterations_arr, stats);
+			break;
+	}
+#else
+	isa_generic::run_kernel<T>(pixels, iterations_arr, stats);
+#endif
+	stats.pixels += pixels.size();
+}
+
+//using the center of the pixel
+template<typename T>
+inline T pixelCenter(int pixel, T start, T end, int image_size) {
+	return ((T(pixel)+T(.5)) * (end - start)) / (image_size) + start;
+}
+//in integers, so the coordinates come out the same everywhere too (the pixel number wouldn't fit in Fixed64 anyway)
+template<>
+inline Fixed64 pixelCenter<Fixed64>(int pixel, Fixed64 start, Fixed64 end, int image_size) {
+	return Fixed64::fromRaw(start.raw + int64_t(((__int128)end.raw - start.raw) * (2*pixel + 1) / (2*image_size)));
+}
+
+//a row's imaginary part, flipped because images have the y-axis going down (so the rows go up)
+//when the view straddles the real axis and the axis falls on a row's center or between two rows (to within MIRROR_SNAP_ULPS of rounding),
+//the row gets measured from the axis instead of from the edge, so rows at mirrored heights come out exact negatives of each other (see mirrorRows())
+const int MIRROR_SNAP_ULPS = 4;
+
+template<typename T>
+inline T rowCenter(int row, T y_start, T y_end, int image_height) {
+	if (y_start < T(0) && T(0) < y_end) {
+		const T axis = (T(2 * image_height) * y_end) / (y_end - y_start); //in half rows from the top
+		const int half_rows = int(std::lround(double(axis)));
+		if (std::fabs(double(axis - T(half_rows))) <= MIRROR_SNAP_ULPS * std::ldexp(double(half_rows), 1 - std::numeric_limits<T>::digits)) {
+			return (T(2*row + 1 - half_rows) * (y_end - y_start)) / T(2 * image_height);
+		}
+	}
+	return pixelCenter(row, -y_end, -y_start, image_height);
+}
+//the integer version rounds towards 0, which is just as symmetric
+template<>
+inline Fixed64 rowCenter<Fixed64>(int row, Fixed64 y_start, Fixed64 y_end, int image_height) {
+	if (y_start.raw < 0 && 0 < y_end.raw) {
+		const __int128 range = (__int128)y_end.raw - y_start.raw;
+		const __int128 axis = (__int128)(2 * image_height) * y_end.raw; //in half rows from the top, times range
+		const int half_rows = int((axis + range / 2) / range);
+		const __int128 off = axis - half_rows * range;
+		if (-MIRROR_SNAP_ULPS * 2 * image_height <= off && off <= MIRROR_SNAP_ULPS * 2 * image_height) {
+			return Fixed64::fromRaw(int64_t(range * (2*row + 1 - half_rows) / (2 * image_height)));
+		}
+	}
+	return pixelCenter(row, -y_end, -y_start, image_height);
+}
+
+//the set is symmetric about the real axis, and so is every kernel (each step only ever negates y, rounding included, Fixed64 too),
+//so a row whose imaginary part is exactly the negative of another row's comes out the same: per row, the row to copy, or -1 to compute it
+//only rows on the side of the real axis with fewer rows get copied, and only if the other side has a row that's their exact negative,
+//which rowCenter() makes happen whenever the axis falls on the pixel grid, so copying never changes the image; otherwise the rows just get computed
+
+template<typename T>
+std::vector<int> mirrorRows(T y_start, T y_end, int image_height) {
+	std::vector<T> pointY_arr(image_height);
+	int negative_rows = 0, positive_rows = 0;
+	for (int y = 0; y < image_height; y++) {
+		pointY_arr[y] = rowCenter(y, y_start, y_end, image_height);
+		negative_rows += (pointY_arr[y] < T(0));
+		positive_rows += (T(0) < pointY_arr[y]);
+	}
+	std::vector<int> mirror_of(image_height, -1);
+	for (int y = 0; y < image_height; y++) {
+		if ((negative_rows <= positive_rows) ? !(pointY_arr[y] < T(0)) : !(T(0) < pointY_arr[y])) {
+			continue;
+		}
+		//the first row at or past the mirror image is the only one that can be exactly it
+		const int match = int(std::lower_bound(pointY_arr.begin(), pointY_arr.end(), -pointY_arr[y]) - pointY_arr.begin());
+		if (match < image_height && !(-pointY_arr[y] < pointY_arr[match])) {
+			mirror_of[y] = match;
+		}
+	}
+	return mirror_of;
+}
+
+//a coloring spread out into an entry for every iteration count, so colorizing a pixel is a single lookup instead of a search
+#ifdef USE_IM6
+typedef Magick::PixelPacket ColorTableEntry;
+#else
+typedef std::array<Magick::Quantum, 3> ColorTableEntry; //ColorRGB does not have an alpha channel
+#endif
+
+std::vector<ColorTableEntry> buildColorTable(const std::vector<std::pair<int, Magick::ColorRGB>>& colors, int max_iterations) {
+	std::vector<ColorTableEntry> colorTable(max_iterations + 1);
+	int colorIndex = 0;
+	for (int iterations = 0; iterations <= max_iterations; iterations++) {
+		//same as searching for the last color whose iteration count has been reached, but incrementally
+		while (colorIndex+1 < colors.size() && iterations >= colors[colorIndex+1].first) {
+			colorIndex++;
+		}
+		#ifdef USE_IM6
+		colorTable[iterations] = colors[colorIndex].second;
+		#else
+		colorTable[iterations] = { colors[colorIndex].second.quantumRed(), colors[colorIndex].second.quantumGreen(), colors[colorIndex].second.quantumBlue() };
+		#endif
+	}
+	return colorTable;
+}
 
+//iterations_arr holds the block [image_x_start, image_x_end) x [image_y_start, image_y_end), which gets colored into the image
+template<typename Count>
+#ifdef USE_IM6
+void colorize(const Count* iterations_arr, const ColorTableEntry* colorTable, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, Magick::PixelPacket* pixel_arr) {
+#else
+void colorize(const Count* iterations_arr, const ColorTableEntry* colorTable, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, Magick::Quantum* pixel_arr) {
+#endif
+	const int row_width = image_x_end - image_x_start;
+	for (int y = image_y_start; y < image_y_end; y++) {
+		const Count* row = iterations_arr + (y - image_y_start) * row_width - image_x_start;
+		for (int x = image_x_start; x < image_x_end; x++) {
 			#ifdef USE_IM6
-			const int arr_pos = y * image_width + x;
-			pixel_arr[arr_pos] = iterationColors[colorIndex].second;
+			pixel_arr[y * image_width + x] = colorTable[row[x]];
 			#else
-			const int arr_pos = 3 * (y * image_width + x); //ColorRGB does not have an alpha channel
-			pixel_arr[arr_pos + 0] = iterationColors[colorIndex].second.quantumRed();
-			pixel_arr[arr_pos + 1] = iterationColors[colorIndex].second.quantumGreen();
-			pixel_arr[arr_pos + 2] = iterationColors[colorIndex].second.quantumBlue();
+			std::copy_n(colorTable[row[x]].data(), 3, pixel_arr + 3 * (y * image_width + x));
 			#endif
 		}
 	}
-	//std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
-
-	//std::cout << "mandelbrot: " << "[" << image_y_start << "," << image_y_end << "] " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
 }
 
-void mandelbrot(int threadCount, c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_width, int image_height, const std::string& output_filename) {
-	//get image ready:
-
-	Magick::Image generated_image;
-	generated_image.size(Magick::Geometry(image_width, image_height));
-	//generated_image.type(Magick::TrueColorType);
-	generated_image.modifyImage();
-	Magick::Pixels view(generated_image);
+template<typename Count>
+struct ColorizeTask : public enki::ITaskSet {
 	#ifdef USE_IM6
-	Magick::PixelPacket* pixel_arr = view.get(0, 0, image_width, image_height);
-	//https://legacy.imagemagick.org/Magick++/Pixels.html
+	Magick::PixelPacket* pixel_arr;
+	ColorizeTask(Magick::PixelPacket* pixels, const Count* iterations_arr, const ColorTableEntry* colorTable, int image_width, int image_height);
 	#else
-	Magick::Quantum* pixel_arr = view.get(0, 0, image_width, image_height);
-	//https://imagemagick.org/Magick++/Pixels.html
+	Magick::Quantum* pixel_arr;
+	ColorizeTask(Magick::Quantum* pixels, const Count* iterations_arr, const ColorTableEntry* colorTable, int image_width, int image_height);
 	#endif
 
-	//calculate mandelbrot:
-
-	MandelbrotTask* mandelbrotTask = new MandelbrotTask(pixel_arr, x_start, x_end, y_start, y_end, image_width, image_height);
-	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
-	g_TS.AddTaskSetToPipe(mandelbrotTask);
-	g_TS.WaitforTask(mandelbrotTask);
-	std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
-	delete mandelbrotTask;
-	std::cout << "mandelbrot: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
-
-	//write image:
+	const Count* iterations_arr;
+	const ColorTableEntry* colorTable;
+	int image_width;
 
-	startTime = std::chrono::steady_clock::now();
-	view.sync();
-	generated_image.write(output_filename);
-	endTime = std::chrono::steady_clock::now();
-	std::cout << "write: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
-}
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
 
-void MandelbrotTask::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
-	int image_x_start = 0;
-	int image_x_end   = image_width;
-	int image_y_start = range_.start;
-	int image_y_end   = range_.end;
-	mandelbrot_helper(x_start, x_end, y_start, y_end, image_x_start, image_x_end, image_width, image_y_start, image_y_end, image_height, pixel_arr);
+template<typename Count>
+void ColorizeTask<Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	colorize(iterations_arr + range_.start * image_width, colorTable, 0, image_width, image_width, range_.start, range_.end, pixel_arr);
 }
 
+template<typename Count>
 #ifdef USE_IM6
-MandelbrotTask::MandelbrotTask(Magick::PixelPacket* pixels, c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_width, int image_height) {
+ColorizeTask<Count>::ColorizeTask(Magick::PixelPacket* pixels, const Count* iterations_arr, const ColorTableEntry* colorTable, int image_width, int image_height) {
 #else
-MandelbrotTask::MandelbrotTask(Magick::Quantum* pixels, c_float x_start, c_float x_end, c_float y_start, c_float y_end, int image_width, int image_height) {
+ColorizeTask<Count>::ColorizeTask(Magick::Quantum* pixels, const Count* iterations_arr, const ColorTableEntry* colorTable, int image_width, int image_height) {
 #endif
-	m_MinRange = 1; //smaller ranges don't help tiny images, but they slightly help very large images
+	m_MinRange = 1;
 	m_SetSize = image_height;
 	pixel_arr = pixels;
-	this->x_start = x_start;
-	this->x_end = x_end;
-	this->y_start = y_start;
-	this->y_end = y_end;
+	this->iterations_arr = iterations_arr;
+	this->colorTable = colorTable;
 	this->image_width = image_width;
-	this->image_height = image_height;
 }
 
+//where the index-th tile along TILE_ORDER's curve is, in a side x side square of tiles (side being a power of 2)
+//the Hilbert curve starts at (0, 0) and ends at (side-1, 0), so squares lined up left to right make one continuous curve
+void curveTile(uint32_t index, int side, int& x, int& y) {
+	x = 0;
+	y = 0;
+	if (TILE_ORDER == TileOrder::morton) {
+		//every other bit of the index is x, the rest are y
+		for (int bit = 0; (1 << bit) < side; bit++) {
+			x |= int((index >> (2*bit)) & 1) << bit;
+			y |= int((index >> (2*bit + 1)) & 1) << bit;
+		}
+		return;
+	}
+	//two bits at a time pick the quadrant, which gets flipped around to keep the curve connected
+	for (int quadrant_size = 1; quadrant_size < side; quadrant_size *= 2) {
+		const int right = 1 & (index / 2);
+		const int top = 1 & (index ^ right);
+		if (!top) {
+			if (right) {
+				x = quadrant_size - 1 - x;
+				y = quadrant_size - 1 - y;
+			}
+			std::swap(x, y);
+		}
+		x += quadrant_size * right;
+		y += quadrant_size * top;
+		index /= 4;
+	}
+}
+
+//where a pixel's orbit was when it ran out of iterations
+template<typename T>
+struct SavedOrbit {
+	uint32_t pixel; //y * image_width + x
+	T x, y;
+};
 
+template<typename T, typename Count>
+struct MandelbrotTask : public enki::ITaskSet {
+	Count* iterations_arr;
+	MandelbrotTask(Count* iterations_arr, T x_start, T x_end, T y_start, T y_end, int image_width, int image_height);
 
-int main(int argc, char** argv) {
-	if (argc < 9) {
-		std::cout << "usage: " << argv[0] << " <num_threads> <x_start> <x_end> <y_start> <y_end> <image_x_size> <image_y_size> <output_name> [<optional coloring file>]" << std::endl;
-		return 1;
-	}
-	Magick::InitializeMagick(argv[0]);
+	T x_start, x_end, y_start, y_end;
+	int image_width, image_height;
+	//with TILE_SIZE: the tiles get covered by a row (or column, if the image is taller than wide) of curve_side x curve_side squares,
+	//with curve_side the smallest power of 2 that covers the short side, so at most about half the curve falls outside the image
+	int tiles_x, tiles_y;
+	int curve_side;
+	//with TileOrder::cost, tile numbers (row by row) from most to least expensive, and how many have been handed out
+	std::vector<uint32_t> cost_order;
+	std::atomic<uint32_t> next_tile = 0;
+	//with SYMMETRY, per row, the row it gets copied from afterwards, or -1 if it gets computed (empty if none get copied)
+	std::vector<int> mirror_of;
+	//with --save-orbits, the pixels that ran out of iterations, in no particular order
+	std::vector<SavedOrbit<T>> orbits;
+	std::mutex orbits_mutex;
 
-	int threadCount; //std::thread::hardware_concurrency() exists but there's no need to use it
-	c_float x_start, x_end, y_start, y_end;
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+//the preview for TileOrder::cost: every PREVIEW_STEP-th pixel of every tile, timed
+template<typename T>
+struct TileCostTask : public enki::ITaskSet {
+	TileCostTask(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height);
+
+	T x_start, x_end, y_start, y_end;
 	int image_width, image_height;
-	std::string output_filename;
-	std::string coloring_filename;
+	int tiles_x;
+	std::vector<int64_t> costs; //in nanoseconds, per tile
+	const std::vector<int>* mirror_of = nullptr; //tiles with every row copied don't cost anything
 
-	threadCount = std::stoi(std::string(argv[1]));
-	threadCount = (threadCount < 1) ? 1 : threadCount;
-	x_start = std::stold(std::string(argv[2]));
-	x_end   = std::stold(std::string(argv[3]));
-	y_start = std::stold(std::string(argv[4]));
-	y_end   = std::stold(std::string(argv[5]));
-	image_width  = std::stoi(std::string(argv[6]));
-	image_height = std::stoi(std::string(argv[7]));
-	output_filename = std::string(argv[8]);
-
-	if (argc >= 10) {
-		coloring_filename = std::string(argv[9]);
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+//iterations_arr gets the block [image_x_start, image_x_end) x [image_y_start, image_y_end), or just every step-th pixel of it both ways
+template<typename T, typename Count>
+void mandelbrot_helper(T x_start, T x_end, T y_start, T y_end, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, int image_height, Count* iterations_arr, int step = 1) {
+	//every row shares the same x coordinates
+	std::vector<T> pointX_arr((image_x_end - image_x_start + step - 1) / step);
+	for (size_t i = 0; i < pointX_arr.size(); i++) {
+		pointX_arr[i] = pixelCenter(image_x_start + int(i) * step, x_start, x_end, image_width);
+	}
+	std::vector<T> pointY_arr((image_y_end - image_y_start + step - 1) / step);
+	for (size_t i = 0; i < pointY_arr.size(); i++) {
+		pointY_arr[i] = rowCenter(image_y_start + int(i) * step, y_start, y_end, image_height);
+	}
+	KernelStats stats;
+
+	//now actually do the calculation:
+	//std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	compute_pixels(GridPixels<T>{ pointX_arr.data(), int(pointX_arr.size()), pointY_arr.data(), int(pointY_arr.size()) }, iterations_arr, stats);
+	addKernelStats(stats);
+	//std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+
+	//std::cout << "mandelbrot: " << "[" << image_y_start << "," << image_y_end << "] " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
+}
+
+//orbitRecords gets the orbits (or rather, what's left of them after resuming), runningPixels how many
+template<typename T>
+void packOrbits(const std::vector<SavedOrbit<T>>& orbits) {
+	const size_t record_size = sizeof(uint32_t) + 2 * sizeof(T);
+	orbitRecords.resize(orbits.size() * record_size);
+	for (size_t i = 0; i < orbits.size(); i++) {
+		uint8_t* record = orbitRecords.data() + i * record_size;
+		std::memcpy(record, &orbits[i].pixel, sizeof(uint32_t));
+		std::memcpy(record + sizeof(uint32_t), &orbits[i].x, sizeof(T));
+		std::memcpy(record + sizeof(uint32_t) + sizeof(T), &orbits[i].y, sizeof(T));
+	}
+	runningPixels = orbits.size();
+}
+
+template<typename T>
+std::vector<SavedOrbit<T>> unpackOrbits() {
+	const size_t record_size = sizeof(uint32_t) + 2 * sizeof(T);
+	std::vector<SavedOrbit<T>> orbits(orbitRecords.size() / record_size);
+	for (size_t i = 0; i < orbits.size(); i++) {
+		const uint8_t* record = orbitRecords.data() + i * record_size;
+		std::memcpy(&orbits[i].pixel, record, sizeof(uint32_t));
+		std::memcpy(&orbits[i].x, record + sizeof(uint32_t), sizeof(T));
+		std::memcpy(&orbits[i].y, record + sizeof(uint32_t) + sizeof(T), sizeof(T));
+	}
+	return orbits;
+}
+
+//adds the orbits of the rows copied from their mirror image (their mirror image's orbits, reflected), and sorts them all by pixel
+template<typename T>
+void mirrorOrbits(std::vector<SavedOrbit<T>>& orbits, const std::vector<int>& mirror_of, int image_width) {
+	auto byPixel = [](const SavedOrbit<T>& a, const SavedOrbit<T>& b) { return a.pixel < b.pixel; };
+	std::sort(orbits.begin(), orbits.end(), byPixel);
+	const size_t computed = orbits.size();
+	for (int y = 0; y < int(mirror_of.size()); y++) {
+		const int source = mirror_of[y];
+		if (source < 0) {
+			continue;
+		}
+		const size_t first = std::lower_bound(orbits.begin(), orbits.begin() + computed, SavedOrbit<T>{ uint32_t(source * image_width) }, byPixel) - orbits.begin();
+		const size_t last = std::lower_bound(orbits.begin(), orbits.begin() + computed, SavedOrbit<T>{ uint32_t((source + 1) * image_width) }, byPixel) - orbits.begin();
+		for (size_t i = first; i < last; i++) {
+			orbits.push_back({ uint32_t(y * image_width) + orbits[i].pixel % image_width, orbits[i].x, -orbits[i].y });
+		}
+	}
+	std::sort(orbits.begin(), orbits.end(), byPixel);
+}
+
+//mandelbrot_helper() for --save-orbits: every pixel's orbit gets kept track of, and the ones that run out of iterations get added to orbits
+template<typename T, typename Count>
+void mandelbrot_orbits(T x_start, T x_end, T y_start, T y_end, int image_x_start, int image_x_end, int image_width, int image_y_start, int image_y_end, int image_height, Count* iterations_arr, std::vector<SavedOrbit<T>>& orbits) {
+	const int block_width = image_x_end - image_x_start;
+	const int count = block_width * (image_y_end - image_y_start);
+	std::vector<T> cx_list(count), cy_list(count);
+	for (int i = 0; i < count; i++) {
+		cx_list[i] = pixelCenter(image_x_start + i % block_width, x_start, x_end, image_width);
+		cy_list[i] = rowCenter(image_y_start + i / block_width, y_start, y_end, image_height);
+	}
+	std::vector<T> zx_list(count, T(0)), zy_list(count, T(0));
+	std::vector<uint8_t> running(count);
+	KernelStats stats;
+	compute_pixels(OrbitPixels<T>{ cx_list.data(), cy_list.data(), zx_list.data(), zy_list.data(), running.data(), 0, count }, iterations_arr, stats);
+	addKernelStats(stats);
+
+	for (int i = 0; i < count; i++) {
+		if (running[i]) {
+			orbits.push_back({ uint32_t((image_y_start + i / block_width) * image_width + image_x_start + i % block_width), zx_list[i], zy_list[i] });
+		}
+	}
+}
+
+//Mariani-Silver subdivision:
+//the set is connected, so if the whole border of a rectangle has the same iteration count, everything inside it does too (at this resolution, anyway)
+//rectangles are inclusive and always have their border computed before they get subdivided, so splitting one only computes the line between the halves
+
+const int SUBDIVIDE_MIN_AREA = 64; //interiors this small just get computed
+const int SUBDIVIDE_TASK_AREA = 128*128; //rectangles this big get their own task
+
+template<typename T, typename Count>
+struct Subdivider {
+	const T* pointX_arr;
+	const T* pointY_arr;
+	int image_width;
+	Count* iterations_arr;
+
+	void computeBlock(int x_start, int x_end, int y_start, int y_end, KernelStats& stats); //exclusive
+	void subdivide(int x0, int x1, int y0, int y1, KernelStats& stats);
+};
+
+template<typename T, typename Count>
+struct SubdivideTask : public enki::ITaskSet {
+	Subdivider<T, Count>* subdivider;
+	int x0, x1, y0, y1;
+	SubdivideTask(Subdivider<T, Count>* subdivider, int x0, int x1, int y0, int y1);
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+template<typename T, typename Count>
+void Subdivider<T, Count>::computeBlock(int x_start, int x_end, int y_start, int y_end, KernelStats& stats) {
+	const int block_width = x_end - x_start;
+	if (block_width == image_width) {
+		compute_pixels(GridPixels<T>{ pointX_arr + x_start, block_width, pointY_arr + y_start, y_end - y_start }, iterations_arr + y_start * image_width, stats);
+		return;
+	}
+	std::vector<Count> block(block_width * (y_end - y_start));
+	compute_pixels(GridPixels<T>{ pointX_arr + x_start, block_width, pointY_arr + y_start, y_end - y_start }, block.data(), stats);
+	for (int y = y_start; y < y_end; y++) {
+		std::copy_n(block.data() + (y - y_start) * block_width, block_width, iterations_arr + y * image_width + x_start);
+	}
+}
+
+template<typename T, typename Count>
+void Subdivider<T, Count>::subdivide(int x0, int x1, int y0, int y1, KernelStats& stats) {
+	if (x1 - x0 < 2 || y1 - y0 < 2) {
+		return; //no interior
+	}
+
+	const int border = iterations_arr[y0 * image_width + x0];
+	bool uniform = true;
+	for (int x = x0; x <= x1 && uniform; x++) {
+		uniform = (iterations_arr[y0 * image_width + x] == border) && (iterations_arr[y1 * image_width + x] == border);
+	}
+	for (int y = y0; y <= y1 && uniform; y++) {
+		uniform = (iterations_arr[y * image_width + x0] == border) && (iterations_arr[y * image_width + x1] == border);
+	}
+	if (uniform) {
+		for (int y = y0+1; y < y1; y++) {
+			std::fill(iterations_arr + y * image_width + x0+1, iterations_arr + y * image_width + x1, border);
+		}
+		return;
+	}
+
+	if ((x1 - x0 - 1) * (y1 - y0 - 1) <= SUBDIVIDE_MIN_AREA) {
+		computeBlock(x0+1, x1, y0+1, y1, stats);
+		return;
+	}
+
+	//split the longer side in half
+	int a_x1 = x1, a_y1 = y1;
+	int b_x0 = x0, b_y0 = y0;
+	if (x1 - x0 >= y1 - y0) {
+		const int x_mid = (x0 + x1) / 2;
+		computeBlock(x_mid, x_mid+1, y0+1, y1, stats);
+		a_x1 = b_x0 = x_mid;
 	} else {
-		coloring_filename = "";
+		const int y_mid = (y0 + y1) / 2;
+		computeBlock(x0+1, x1, y_mid, y_mid+1, stats);
+		a_y1 = b_y0 = y_mid;
 	}
-	if (coloring_filename.size() > 0) {
-		readColorFileAndSetColors(coloring_filename);
+
+	if ((x1 - x0) * (y1 - y0) >= SUBDIVIDE_TASK_AREA) {
+		SubdivideTask<T, Count> second(this, b_x0, x1, b_y0, y1);
+		g_TS.AddTaskSetToPipe(&second);
+		subdivide(x0, a_x1, y0, a_y1, stats);
+		g_TS.WaitforTask(&second);
+	} else {
+		subdivide(x0, a_x1, y0, a_y1, stats);
+		subdivide(b_x0, x1, b_y0, y1, stats);
 	}
+}
 
-	g_TS.Initialize(threadCount);
+template<typename T, typename Count>
+void SubdivideTask<T, Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	KernelStats stats;
+	subdivider->subdivide(x0, x1, y0, y1, stats);
+	addKernelStats(stats);
+}
 
-	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+template<typename T, typename Count>
+SubdivideTask<T, Count>::SubdivideTask(Subdivider<T, Count>* subdivider, int x0, int x1, int y0, int y1) {
+	m_SetSize = 1;
+	this->subdivider = subdivider;
+	this->x0 = x0;
+	this->x1 = x1;
+	this->y0 = y0;
+	this->y1 = y1;
+}
+
+//boundary tracing:
+//an area of one iteration count can only be entered by crossing its edge, so only pixels along edges between different iteration counts need computing, and everything else gets filled in from the left
+//the image is cut into bands whose top and bottom rows (plus a few seed columns) get computed first; after that, each band can follow its edges without touching another band's pixels
+//(an area that doesn't touch a computed row/column or an edge leading to one would get missed; the seed rows and columns leave only features smaller than BOUNDARY_GRID,
+//in practice single escaping pixels where a filament too thin to show up anywhere else crosses an inside area near its edge, which is what trace()'s check pass computes)
+
+const int BOUNDARY_GRID = 32; //band height and seed column spacing
+const int BOUNDARY_CHECK_DISTANCE = 16; //how far from an edge filled pixels get checked
+template<typename Count> constexpr Count UNCOMPUTED = std::numeric_limits<Count>::max();
+template<typename Count> constexpr Count QUEUED = UNCOMPUTED<Count> - 1;
+
+template<typename T, typename Count>
+struct BoundaryTracer {
+	const T* pointX_arr;
+	const T* pointY_arr;
+	int image_width, image_height;
+	Count* iterations_arr;
+
+	//band i covers rows [i*BOUNDARY_GRID, (i+1)*BOUNDARY_GRID], so neighboring bands share a row
+	int bandCount() const { return (image_height - 1 + BOUNDARY_GRID-1) / BOUNDARY_GRID; }
+	int bandStart(int band) const { return band * BOUNDARY_GRID; }
+	int bandEnd(int band) const { return std::min((band+1) * BOUNDARY_GRID, image_height-1); }
+
+	void computeList(const std::vector<int>& pixel_list, KernelStats& stats);
+	void computeFrame(int band, KernelStats& stats);
+	void trace(int y0, int y1, KernelStats& stats);
+};
+
+template<typename T, typename Count>
+struct BoundaryTraceTask : public enki::ITaskSet {
+	BoundaryTracer<T, Count>* tracer;
+	bool frame; //the first pass only computes the band frames
+	BoundaryTraceTask(BoundaryTracer<T, Count>* tracer, bool frame);
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+template<typename T, typename Count>
+void BoundaryTracer<T, Count>::computeList(const std::vector<int>& pixel_list, KernelStats& stats) {
+	std::vector<T> cx_list(pixel_list.size()), cy_list(pixel_list.size());
+	for (size_t i = 0; i < pixel_list.size(); i++) {
+		cx_list[i] = pointX_arr[pixel_list[i] % image_width];
+		cy_list[i] = pointY_arr[pixel_list[i] / image_width];
+	}
+	std::vector<Count> results(pixel_list.size());
+	compute_pixels(ListPixels<T>{ cx_list.data(), cy_list.data(), int(pixel_list.size()) }, results.data(), stats);
+	for (size_t i = 0; i < pixel_list.size(); i++) {
+		iterations_arr[pixel_list[i]] = results[i];
+	}
+}
+
+template<typename T, typename Count>
+void BoundaryTracer<T, Count>::computeFrame(int band, KernelStats& stats) {
+	const int y0 = bandStart(band), y1 = bandEnd(band);
+	std::vector<int> pixel_list;
+	for (int x = 0; x < image_width; x++) {
+		pixel_list.push_back(y0 * image_width + x);
+	}
+	if (band == bandCount()-1) {
+		for (int x = 0; x < image_width; x++) {
+			pixel_list.push_back(y1 * image_width + x);
+		}
+	}
+	for (int y = y0+1; y < y1; y++) {
+		for (int x = 0; x < image_width; x += BOUNDARY_GRID) {
+			pixel_list.push_back(y * image_width + x);
+		}
+		if ((image_width-1) % BOUNDARY_GRID != 0) {
+			pixel_list.push_back(y * image_width + image_width-1);
+		}
+	}
+	computeList(pixel_list, stats);
+}
+
+//follows the edges between the computed rows y0 and y1, which may be several bands apart
+template<typename T, typename Count>
+void BoundaryTracer<T, Count>::trace(int y0, int y1, KernelStats& stats) {
+	auto value = [&](int pixel) { return iterations_arr[pixel]; };
+	std::vector<uint8_t> expanded((y1 - y0 + 1) * image_width, 0); //whether a pixel's neighbors have been queued
+	auto isExpanded = [&](int pixel) -> uint8_t& { return expanded[pixel - y0 * image_width]; };
+	std::vector<int> frontier, next_frontier, pixel_list, filled;
+	std::vector<int> distance((y1 - y0 + 1) * image_width);
 
-	mandelbrot(threadCount, x_start, x_end, y_start, y_end, image_width, image_height, output_filename);
+	for (;;) {
+		//everything computed so far in this band starts out as the frontier
+		frontier.clear();
+		for (int pixel = y0 * image_width; pixel < (y1+1) * image_width; pixel++) {
+			if (value(pixel) < QUEUED<Count> && !isExpanded(pixel)) {
+				frontier.push_back(pixel);
+			}
+		}
+
+		while (!frontier.empty()) {
+			next_frontier.clear();
+			pixel_list.clear();
+
+			for (const int pixel : frontier) {
+				if (isExpanded(pixel)) {
+					continue;
+				}
+				const int x = pixel % image_width, y = pixel / image_width;
+				//diagonal neighbors count too, otherwise areas that only touch at a corner get lost
+				int neighbors[8];
+				int neighbor_count = 0;
+				for (int ny = std::max(y-1, y0); ny <= std::min(y+1, y1); ny++) {
+					for (int nx = std::max(x-1, 0); nx <= std::min(x+1, image_width-1); nx++) {
+						if (nx != x || ny != y) {
+							neighbors[neighbor_count++] = ny * image_width + nx;
+						}
+					}
+				}
+
+				//only pixels next to a different iteration count are on an edge
+				bool edge = false;
+				for (int i = 0; i < neighbor_count; i++) {
+					const int neighbor = neighbors[i];
+					if (value(neighbor) < QUEUED<Count> && value(neighbor) != value(pixel)) {
+						edge = true;
+						if (!isExpanded(neighbor)) {
+							next_frontier.push_back(neighbor); //it's on the same edge, from the other side
+						}
+					}
+				}
+				if (!edge) {
+					continue;
+				}
+
+				isExpanded(pixel) = 1;
+				for (int i = 0; i < neighbor_count; i++) {
+					const int neighbor = neighbors[i];
+					if (value(neighbor) == UNCOMPUTED<Count>) {
+						iterations_arr[neighbor] = QUEUED<Count>;
+						pixel_list.push_back(neighbor);
+					}
+				}
+			}
+
+			//the whole wave goes to the kernel at once so the SIMD lanes have something to do
+			computeList(pixel_list, stats);
+			frontier.swap(next_frontier);
+			frontier.insert(frontier.end(), pixel_list.begin(), pixel_list.end());
+		}
+
+		//anything left is surrounded by a single iteration count (column 0 is always computed)
+		filled.clear();
+		for (int y = y0+1; y < y1; y++) {
+			for (int x = 1; x < image_width; x++) {
+				if (value(y * image_width + x) == UNCOMPUTED<Count>) {
+					iterations_arr[y * image_width + x] = value(y * image_width + x-1);
+					filled.push_back(y * image_width + x);
+				}
+			}
+		}
+
+		//check: a filament too thin to land on any other pixel can still leave a single pixel escaping in the middle of a filled inside area,
+		//so the filled pixels up to BOUNDARY_CHECK_DISTANCE into an inside area (breadth-first in from its edges) get computed after all;
+		//whatever comes out different is a new edge for the next round to follow
+		std::fill(distance.begin(), distance.end(), -1);
+		frontier.clear();
+		for (int pixel = y0 * image_width; pixel < (y1+1) * image_width; pixel++) {
+			if (isExpanded(pixel) && value(pixel) == MAX_ITER) {
+				distance[pixel - y0 * image_width] = 0;
+				frontier.push_back(pixel);
+			}
+		}
+		pixel_list.clear();
+		for (size_t i = 0; i < frontier.size(); i++) {
+			const int pixel = frontier[i];
+			const int x = pixel % image_width, y = pixel / image_width;
+			const int d = distance[pixel - y0 * image_width];
+			if (d == BOUNDARY_CHECK_DISTANCE) {
+				continue;
+			}
+			for (int ny = std::max(y-1, y0+1); ny <= std::min(y+1, y1-1); ny++) {
+				for (int nx = std::max(x-1, 0); nx <= std::min(x+1, image_width-1); nx++) {
+					const int neighbor = ny * image_width + nx;
+					if (distance[neighbor - y0 * image_width] < 0 && value(neighbor) == MAX_ITER) {
+						distance[neighbor - y0 * image_width] = d + 1;
+						frontier.push_back(neighbor);
+					}
+				}
+			}
+		}
+		for (const int pixel : filled) {
+			if (distance[pixel - y0 * image_width] > 0) {
+				pixel_list.push_back(pixel);
+			}
+		}
+		computeList(pixel_list, stats);
+		bool missed = false;
+		for (const int pixel : pixel_list) {
+			missed |= (value(pixel) != MAX_ITER);
+		}
+		if (!missed) {
+			break;
+		}
+		//the rest of the fill goes back to uncomputed, so the next round can follow the new edges into it
+		for (const int pixel : filled) {
+			if (distance[pixel - y0 * image_width] <= 0) {
+				iterations_arr[pixel] = UNCOMPUTED<Count>;
+			}
+		}
+	}
+}
+
+template<typename T, typename Count>
+void BoundaryTraceTask<T, Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	KernelStats stats;
+	if (frame) {
+		for (int band = range_.start; band < int(range_.end); band++) {
+			tracer->computeFrame(band, stats);
+		}
+	} else {
+		//tracing all bands of the range together makes for bigger batches than tracing them one by one
+		tracer->trace(tracer->bandStart(range_.start), tracer->bandEnd(range_.end-1), stats);
+	}
+	addKernelStats(stats);
+}
+
+template<typename T, typename Count>
+BoundaryTraceTask<T, Count>::BoundaryTraceTask(BoundaryTracer<T, Count>* tracer, bool frame) {
+	m_MinRange = 1;
+	m_SetSize = tracer->bandCount();
+	this->tracer = tracer;
+	this->frame = frame;
+}
+
+//solid guessing:
+//pixels get computed on a grid that gets twice as fine every pass (every 8th pixel, then every 4th, 2nd, and finally all of them)
+//a pixel whose four surrounding pixels from the previous pass all agree is probably in the middle of a flat area, so it just takes their value
+//(this misses anything that fits between the previous pass's pixels, so the result isn't always identical)
+
+const int GUESS_FIRST_STEP = 8;
+
+template<typename T, typename Count>
+struct GuessPassTask : public enki::ITaskSet {
+	const T* pointX_arr;
+	const T* pointY_arr;
+	int image_width, image_height;
+	Count* iterations_arr;
+	int step; //this pass fills in every step-th pixel of every step-th row
+	enki::Dependency previousPass;
+	GuessPassTask(const T* pointX_arr, const T* pointY_arr, int image_width, int image_height, Count* iterations_arr, int step, const GuessPassTask* previous);
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+template<typename T, typename Count>
+void GuessPassTask<T, Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	KernelStats stats;
+	const int coarse = step * 2; //the previous pass's grid
+	std::vector<int> pixel_list;
+	std::vector<T> cx_list, cy_list;
+
+	for (int y = range_.start; y < int(range_.end); y++) {
+		if (y % step != 0) {
+			continue;
+		}
+		for (int x = 0; x < image_width; x += step) {
+			if (step == GUESS_FIRST_STEP) {
+				pixel_list.push_back(y * image_width + x);
+				continue;
+			}
+			if (x % coarse == 0 && y % coarse == 0) {
+				continue; //done by an earlier pass
+			}
+
+			const int x0 = x - x % coarse, x1 = (x % coarse == 0) ? x0 : x0 + coarse;
+			const int y0 = y - y % coarse, y1 = (y % coarse == 0) ? y0 : y0 + coarse;
+			if (x1 >= image_width || y1 >= image_height) {
+				pixel_list.push_back(y * image_width + x); //nothing to guess from past the edge
+				continue;
+			}
+			const int guess = iterations_arr[y0 * image_width + x0];
+			if (iterations_arr[y0 * image_width + x1] == guess && iterations_arr[y1 * image_width + x0] == guess && iterations_arr[y1 * image_width + x1] == guess) {
+				iterations_arr[y * image_width + x] = guess;
+			} else {
+				pixel_list.push_back(y * image_width + x);
+			}
+		}
+	}
+
+	cx_list.resize(pixel_list.size());
+	cy_list.resize(pixel_list.size());
+	for (size_t i = 0; i < pixel_list.size(); i++) {
+		cx_list[i] = pointX_arr[pixel_list[i] % image_width];
+		cy_list[i] = pointY_arr[pixel_list[i] / image_width];
+	}
+	std::vector<Count> results(pixel_list.size());
+	compute_pixels(ListPixels<T>{ cx_list.data(), cy_list.data(), int(pixel_list.size()) }, results.data(), stats);
+	for (size_t i = 0; i < pixel_list.size(); i++) {
+		iterations_arr[pixel_list[i]] = results[i];
+	}
+	addKernelStats(stats);
+}
+
+template<typename T, typename Count>
+GuessPassTask<T, Count>::GuessPassTask(const T* pointX_arr, const T* pointY_arr, int image_width, int image_height, Count* iterations_arr, int step, const GuessPassTask* previous) {
+	m_MinRange = step; //only every step-th row has anything to do
+	m_SetSize = image_height;
+	this->pointX_arr = pointX_arr;
+	this->pointY_arr = pointY_arr;
+	this->image_width = image_width;
+	this->image_height = image_height;
+	this->iterations_arr = iterations_arr;
+	this->step = step;
+	if (previous) {
+		SetDependency(previousPass, previous);
+	}
+}
+
+template<typename T, typename Count>
+void mandelbrot_subdivide(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height, Count* iterations_arr) {
+	std::vector<T> pointX_arr(image_width);
+	std::vector<T> pointY_arr(image_height);
+	for (int x = 0; x < image_width; x++) {
+		pointX_arr[x] = pixelCenter(x, x_start, x_end, image_width);
+	}
+	for (int y = 0; y < image_height; y++) {
+		pointY_arr[y] = rowCenter(y, y_start, y_end, image_height);
+	}
+	Subdivider<T, Count> subdivider = { pointX_arr.data(), pointY_arr.data(), image_width, iterations_arr };
+
+	KernelStats stats;
+	if (image_width <= 2 || image_height <= 2) {
+		//no interior to skip (and the border rows/columns below would overlap or be empty)
+		subdivider.computeBlock(0, image_width, 0, image_height, stats);
+		addKernelStats(stats);
+		return;
+	}
+
+	//the whole image is the first rectangle
+	subdivider.computeBlock(0, image_width, 0, 1, stats);
+	subdivider.computeBlock(0, image_width, image_height-1, image_height, stats);
+	subdivider.computeBlock(0, 1, 1, image_height-1, stats);
+	subdivider.computeBlock(image_width-1, image_width, 1, image_height-1, stats);
+	addKernelStats(stats);
+
+	SubdivideTask<T, Count> subdivideTask(&subdivider, 0, image_width-1, 0, image_height-1);
+	g_TS.AddTaskSetToPipe(&subdivideTask);
+	g_TS.WaitforTask(&subdivideTask);
+
+}
+
+template<typename T, typename Count>
+void mandelbrot_boundary(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height, Count* iterations_arr) {
+	std::vector<T> pointX_arr(image_width);
+	std::vector<T> pointY_arr(image_height);
+	for (int x = 0; x < image_width; x++) {
+		pointX_arr[x] = pixelCenter(x, x_start, x_end, image_width);
+	}
+	for (int y = 0; y < image_height; y++) {
+		pointY_arr[y] = rowCenter(y, y_start, y_end, image_height);
+	}
+	std::fill_n(iterations_arr, image_width * image_height, UNCOMPUTED<Count>);
+	BoundaryTracer<T, Count> tracer = { pointX_arr.data(), pointY_arr.data(), image_width, image_height, iterations_arr };
+
+	if (image_height == 1) {
+		//no bands to make
+		KernelStats stats;
+		compute_pixels(GridPixels<T>{ pointX_arr.data(), image_width, pointY_arr.data(), 1 }, iterations_arr, stats);
+		addKernelStats(stats);
+	} else {
+		BoundaryTraceTask<T, Count> frameTask(&tracer, true);
+		g_TS.AddTaskSetToPipe(&frameTask);
+		g_TS.WaitforTask(&frameTask);
+
+		BoundaryTraceTask<T, Count> traceTask(&tracer, false);
+		g_TS.AddTaskSetToPipe(&traceTask);
+		g_TS.WaitforTask(&traceTask);
+	}
+
+}
+
+template<typename T, typename Count>
+void mandelbrot_guess(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height, Count* iterations_arr) {
+	std::vector<T> pointX_arr(image_width);
+	std::vector<T> pointY_arr(image_height);
+	for (int x = 0; x < image_width; x++) {
+		pointX_arr[x] = pixelCenter(x, x_start, x_end, image_width);
+	}
+	for (int y = 0; y < image_height; y++) {
+		pointY_arr[y] = rowCenter(y, y_start, y_end, image_height);
+	}
+
+	//each pass only starts once the one before it is done
+	std::vector<std::unique_ptr<GuessPassTask<T, Count>>> passes;
+	for (int step = GUESS_FIRST_STEP; step >= 1; step /= 2) {
+		passes.push_back(std::make_unique<GuessPassTask<T, Count>>(pointX_arr.data(), pointY_arr.data(), image_width, image_height, iterations_arr, step, passes.empty() ? nullptr : passes.back().get()));
+	}
+	g_TS.AddTaskSetToPipe(passes.front().get());
+	g_TS.WaitforTask(passes.back().get());
+}
+
+//one coloring of the computed iterations, written to its own file
+struct ImageOutput {
+	std::string filename;
+	std::vector<std::pair<int, Magick::ColorRGB>> colors;
+	int64_t colorizeMs = 0, writeMs = 0; //filled in by writeImage()
+};
+
+template<typename Count>
+void writeImage(const Count* iterations_arr, int image_width, int image_height, int max_iterations, ImageOutput& output) {
+	//get image ready:
+
+	Magick::Image generated_image;
+	generated_image.size(Magick::Geometry(image_width, image_height));
+	//generated_image.type(Magick::TrueColorType);
+	generated_image.modifyImage();
+	Magick::Pixels view(generated_image);
+	#ifdef USE_IM6
+	Magick::PixelPacket* pixel_arr = view.get(0, 0, image_width, image_height);
+	//https://legacy.imagemagick.org/Magick++/Pixels.html
+	#else
+	Magick::Quantum* pixel_arr = view.get(0, 0, image_width, image_height);
+	//https://imagemagick.org/Magick++/Pixels.html
+	#endif
+
+	//colorize:
+
+	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	const std::vector<ColorTableEntry> colorTable = buildColorTable(output.colors, max_iterations);
+	ColorizeTask<Count> colorizeTask(pixel_arr, iterations_arr, colorTable.data(), image_width, image_height);
+	g_TS.AddTaskSetToPipe(&colorizeTask);
+	g_TS.WaitforTask(&colorizeTask);
+	std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+	output.colorizeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+	//write image:
+
+	startTime = std::chrono::steady_clock::now();
+	view.sync();
+	generated_image.write(output.filename);
+	endTime = std::chrono::steady_clock::now();
+	output.writeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+}
+
+//every output gets colored and encoded at the same time, since encoding is mostly single-threaded
+template<typename Count>
+struct WriteImageTask : public enki::ITaskSet {
+	const Count* iterations_arr;
+	int image_width, image_height, max_iterations;
+	std::vector<ImageOutput>* outputs;
+	WriteImageTask(const Count* iterations_arr, int image_width, int image_height, int max_iterations, std::vector<ImageOutput>* outputs);
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+template<typename Count>
+void WriteImageTask<Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	for (int i = range_.start; i < int(range_.end); i++) {
+		writeImage(iterations_arr, image_width, image_height, max_iterations, (*outputs)[i]);
+	}
+}
+
+template<typename Count>
+WriteImageTask<Count>::WriteImageTask(const Count* iterations_arr, int image_width, int image_height, int max_iterations, std::vector<ImageOutput>* outputs) {
+	m_MinRange = 1;
+	m_SetSize = outputs->size();
+	this->iterations_arr = iterations_arr;
+	this->image_width = image_width;
+	this->image_height = image_height;
+	this->max_iterations = max_iterations;
+	this->outputs = outputs;
+}
+
+template<typename Count>
+void writeImages(const Count* iterations_arr, int image_width, int image_height, int max_iterations, std::vector<ImageOutput>& outputs) {
+	WriteImageTask<Count> writeImageTask(iterations_arr, image_width, image_height, max_iterations, &outputs);
+	g_TS.AddTaskSetToPipe(&writeImageTask);
+	g_TS.WaitforTask(&writeImageTask);
+
+	for (const ImageOutput& output : outputs) {
+		const std::string prefix = (outputs.size() > 1) ? output.filename + ": " : "";
+		std::cout << prefix << "colorize: " << output.colorizeMs << "ms" << std::endl;
+		std::cout << prefix << "write: " << output.writeMs << "ms" << std::endl;
+	}
+}
+
+//iteration cache:
+//--save-iterations writes the raw iteration counts to a file, and --recolor maps that file back in to color it without computing anything
+//the layout is IterationCacheHeader (64 bytes, native byte order) followed by the image_width*image_height iteration counts (iter_size bytes each), row by row from the top
+
+struct IterationCacheHeader {
+	char magic[8]; //"MANDITER"
+	uint32_t version;
+	uint32_t iter_size; //2 (uint16_t) or 4 (uint32_t)
+	uint32_t float_size; //size of the type the pixel coordinates were computed in
+	int32_t max_iter;
+	int32_t image_width, image_height;
+	double x_start, x_end, y_start, y_end;
+};
+static_assert(sizeof(IterationCacheHeader) == 64, "the iteration cache header layout is part of the file format");
+
+const char ITERATION_CACHE_MAGIC[8] = { 'M', 'A', 'N', 'D', 'I', 'T', 'E', 'R' };
+const uint32_t ITERATION_CACHE_VERSION = 1;
+
+template<typename Count>
+void saveIterations(const std::string& filename, const Count* iterations_arr, double x_start, double x_end, double y_start, double y_end, int image_width, int image_height, int float_size) {
+	IterationCacheHeader header;
+	std::copy_n(ITERATION_CACHE_MAGIC, 8, header.magic);
+	header.version = ITERATION_CACHE_VERSION;
+	header.iter_size = sizeof(Count);
+	header.float_size = float_size;
+	header.max_iter = MAX_ITER;
+	header.image_width = image_width;
+	header.image_height = image_height;
+	header.x_start = x_start;
+	header.x_end = x_end;
+	header.y_start = y_start;
+	header.y_end = y_end;
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Could not open file \"" + filename + "\"");
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(iterations_arr), sizeof(Count) * image_width * image_height);
+	if (!file) {
+		throw std::runtime_error("Could not write to file \"" + filename + "\"");
+	}
+}
+
+void recolor(const std::string& cache_filename, std::vector<ImageOutput>& outputs) {
+	const int fd = open(cache_filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Could not open file \"" + cache_filename + "\"");
+	}
+	struct stat file_info;
+	fstat(fd, &file_info);
+	const size_t file_size = file_info.st_size;
+	void* mapping = (file_size >= sizeof(IterationCacheHeader)) ? mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd); //the mapping keeps the file around
+	if (mapping == MAP_FAILED) {
+		throw std::runtime_error("Could not map file \"" + cache_filename + "\"");
+	}
+
+	const IterationCacheHeader& header = *static_cast<const IterationCacheHeader*>(mapping);
+	if (!std::equal(ITERATION_CACHE_MAGIC, ITERATION_CACHE_MAGIC + 8, header.magic) || header.version != ITERATION_CACHE_VERSION) {
+		throw std::runtime_error("\"" + cache_filename + "\" is not an iteration cache");
+	}
+	if (header.iter_size != sizeof(uint16_t) && header.iter_size != sizeof(uint32_t)) {
+		throw std::runtime_error("\"" + cache_filename + "\" has " + std::to_string(header.iter_size) + "-byte iteration counts");
+	}
+	if (file_size < sizeof(IterationCacheHeader) + size_t(header.iter_size) * header.image_width * header.image_height) {
+		throw std::runtime_error("\"" + cache_filename + "\" is cut off");
+	}
+	std::cout << "recoloring: [" << header.x_start << ", " << header.x_end << "] x [" << header.y_start << ", " << header.y_end << "], "
+		<< header.image_width << "x" << header.image_height << ", max iterations " << header.max_iter << " (computed with " << header.float_size << "-byte floats)" << std::endl;
+	if (header.max_iter != MAX_ITER) {
+		std::cout << "warning: the coloring's max iterations (" << MAX_ITER << ") don't match the cache's" << std::endl;
+	}
+
+	//the iteration counts get read straight out of the mapping, so only the pages colorizing touches get loaded
+	madvise(mapping, file_size, MADV_SEQUENTIAL);
+	const char* iterations_arr = static_cast<const char*>(mapping) + sizeof(IterationCacheHeader);
+	if (header.iter_size == sizeof(uint32_t)) {
+		writeImages(reinterpret_cast<const uint32_t*>(iterations_arr), header.image_width, header.image_height, std::max<int>(header.max_iter, MAX_ITER), outputs);
+	} else {
+		writeImages(reinterpret_cast<const uint16_t*>(iterations_arr), header.image_width, header.image_height, std::max<int>(header.max_iter, MAX_ITER), outputs);
+	}
+
+	munmap(mapping, file_size);
+}
+
+//orbit file:
+//--save-orbits writes the iteration counts, plus where each pixel that ran out of iterations (instead of escaping or getting caught in a cycle) left off,
+//and --resume-orbits picks just those back up with a higher MAX_ITER, so everything that already escaped or is known to be inside doesn't get computed again
+//the layout is OrbitFileHeader (64 bytes, native byte order), the image_width*image_height iteration counts (iter_size bytes each) row by row from the top,
+//a uint64_t count, then that many records: the pixel (uint32_t, y*image_width + x), then z's real and imaginary parts as the precision's type
+
+struct OrbitFileHeader {
+	char magic[8]; //"MANDORBT"
+	uint32_t version;
+	uint32_t iter_size; //2 (uint16_t) or 4 (uint32_t)
+	uint32_t precision; //Precision, which is also what z is stored as
+	int32_t max_iter; //where the saved orbits stopped
+	int32_t image_width, image_height;
+	double x_start, x_end, y_start, y_end;
+};
+static_assert(sizeof(OrbitFileHeader) == 64, "the orbit file header layout is part of the file format");
+
+const char ORBIT_FILE_MAGIC[8] = { 'M', 'A', 'N', 'D', 'O', 'R', 'B', 'T' };
+const uint32_t ORBIT_FILE_VERSION = 1;
+
+template<typename Count>
+void saveOrbits(const std::string& filename, const Count* iterations_arr, double x_start, double x_end, double y_start, double y_end, int image_width, int image_height) {
+	OrbitFileHeader header;
+	std::copy_n(ORBIT_FILE_MAGIC, 8, header.magic);
+	header.version = ORBIT_FILE_VERSION;
+	header.iter_size = sizeof(Count);
+	header.precision = uint32_t(PRECISION);
+	header.max_iter = MAX_ITER;
+	header.image_width = image_width;
+	header.image_height = image_height;
+	header.x_start = x_start;
+	header.x_end = x_end;
+	header.y_start = y_start;
+	header.y_end = y_end;
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Could not open file \"" + filename + "\"");
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(iterations_arr), sizeof(Count) * image_width * image_height);
+	file.write(reinterpret_cast<const char*>(&runningPixels), sizeof(runningPixels));
+	file.write(reinterpret_cast<const char*>(orbitRecords.data()), orbitRecords.size());
+	if (!file) {
+		throw std::runtime_error("Could not write to file \"" + filename + "\"");
+	}
+}
+
+//opens an orbit file and reads its header, leaving file at the iteration counts
+OrbitFileHeader openOrbits(const std::string& filename, std::ifstream& file) {
+	file.open(filename, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Could not open file \"" + filename + "\"");
+	}
+	OrbitFileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !std::equal(ORBIT_FILE_MAGIC, ORBIT_FILE_MAGIC + 8, header.magic) || header.version != ORBIT_FILE_VERSION) {
+		throw std::runtime_error("\"" + filename + "\" is not an orbit file");
+	}
+	return header;
+}
+
+//reads the header, the iteration counts and the orbits (into orbitRecords)
+//a file saved with 16-bit counts gets widened, since going from a max iterations below 65534 to one above it is the usual reason to pick orbits back up
+template<typename Count>
+OrbitFileHeader loadOrbits(const std::string& filename, Count* iterations_arr) {
+	std::ifstream file;
+	const OrbitFileHeader header = openOrbits(filename, file);
+	const size_t pixels = size_t(header.image_width) * header.image_height;
+	if (header.iter_size == sizeof(Count)) {
+		file.read(reinterpret_cast<char*>(iterations_arr), sizeof(Count) * pixels);
+	} else if (header.iter_size == sizeof(uint16_t)) {
+		std::vector<uint16_t> saved(pixels);
+		file.read(reinterpret_cast<char*>(saved.data()), sizeof(uint16_t) * pixels);
+		std::copy(saved.begin(), saved.end(), iterations_arr);
+	} else {
+		//32-bit counts only get saved past 65533 iterations, so this is resumeImage()'s check failing early
+		throw std::runtime_error("\"" + filename + "\" already went to " + std::to_string(header.max_iter) + " iterations, so the coloring's max iterations (" + std::to_string(MAX_ITER) + ") have to be higher to pick it up");
+	}
+	const Precision precision = Precision(header.precision);
+	const size_t float_size = (precision == Precision::float_) ? sizeof(float) : (precision == Precision::double_) ? sizeof(double)
+		: (precision == Precision::long_double) ? sizeof(long double) : (precision == Precision::fixed) ? sizeof(Fixed64) : sizeof(DoubleDouble);
+	file.read(reinterpret_cast<char*>(&runningPixels), sizeof(runningPixels));
+	orbitRecords.resize((sizeof(uint32_t) + 2 * float_size) * (file ? runningPixels : 0));
+	if (!file || !file.read(reinterpret_cast<char*>(orbitRecords.data()), orbitRecords.size())) {
+		throw std::runtime_error("\"" + filename + "\" is cut off");
+	}
+	return header;
+}
+
+//long double would cut coordinates off at 64 bits, so double-double ones go through FixedPoint
+template<typename T>
+T parseCoordinate(const std::string& str) {
+	return T(std::stold(str));
+}
+template<>
+DoubleDouble parseCoordinate<DoubleDouble>(const std::string& str) {
+	//every digit given, plus 128 bits so the lo part still gets its 53 bits below the hi part's
+	const int limbs = FixedPoint::fractionLimbsFor(str) + 4;
+	const FixedPoint fixed = FixedPoint::fromString(str, limbs);
+	const double hi = fixed.toDouble();
+	return DoubleDouble(hi, (fixed - FixedPoint::fromDouble(hi, limbs)).toDouble());
+}
+template<>
+Fixed64 parseCoordinate<Fixed64>(const std::string& str) {
+	return Fixed64::fromRaw(FixedPoint::fromString(str, 2).toInt64(Fixed64::FRACTION_BITS));
+}
+
+const char* precisionName(Precision precision) {
+	switch (precision) {
+		case Precision::float_: return "float";
+		case Precision::double_: return "double";
+		case Precision::long_double: return "long double";
+		case Precision::double_double: return "double-double";
+		case Precision::mixed: return "mixed";
+		case Precision::fixed: return "64-bit fixed point";
+		default: return "automatic";
+	}
+}
+
+const int PRECISION_MARGIN_BITS = 10; //past what it takes to tell neighboring pixels apart, for rounding errors to build up in
+
+//whether double-double is cheaper than long double on the kernels that are going to run: it only gets SIMD with FMA, and then it's
+//~1.3x faster than long double with AVX-512 and about even with AVX2; without FMA (or SIMD) it's ~5x slower
+bool doubleDoubleBeatsLongDouble() {
+#if defined(__x86_64__)
+	return SIMD_LEVEL == SimdLevel::avx512 && (KERNEL_TYPE == KernelType::refill || KERNEL_TYPE == KernelType::simd);
+#else
+	return false;
+#endif
+}
+
+//the cheapest precision with margin_bits to spare after telling apart coordinates around magnitude that are pixel_size apart
+Precision precisionFor(double magnitude, double pixel_size, int margin_bits) {
+	const double bits = std::log2(magnitude / pixel_size) + margin_bits;
+	if (bits <= std::numeric_limits<float>::digits) {
+		return Precision::float_;
+	} else if (bits <= std::numeric_limits<double>::digits) {
+		return Precision::double_;
+	} else if (bits <= std::numeric_limits<long double>::digits && !doubleDoubleBeatsLongDouble()) {
+		return Precision::long_double;
+	}
+	return Precision::double_double;
+}
+
+//in double-double so the pixel size doesn't get lost to rounding in the subtraction
+double pixelSize(DoubleDouble x_start, DoubleDouble x_end, DoubleDouble y_start, DoubleDouble y_end, int image_width, int image_height) {
+	return std::min(std::fabs(double(x_end - x_start)) / image_width, std::fabs(double(y_end - y_start)) / image_height);
+}
+
+//the cheapest precision that can still tell neighboring pixels apart
+Precision pickPrecision(const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height) {
+	const DoubleDouble xs = parseCoordinate<DoubleDouble>(x_start), xe = parseCoordinate<DoubleDouble>(x_end);
+	const DoubleDouble ys = parseCoordinate<DoubleDouble>(y_start), ye = parseCoordinate<DoubleDouble>(y_end);
+	const double pixel_size = pixelSize(xs, xe, ys, ye, image_width, image_height);
+	const double magnitude = std::max({ std::fabs(double(xs)), std::fabs(double(xe)), std::fabs(double(ys)), std::fabs(double(ye)) });
+
+	if (std::log2(magnitude / pixel_size) + PRECISION_MARGIN_BITS > std::numeric_limits<DoubleDouble>::digits) {
+		std::cout << "warning: even double-double can't tell the pixels apart at this zoom, try --perturbation" << std::endl;
+	}
+	return precisionFor(magnitude, pixel_size, PRECISION_MARGIN_BITS);
+}
+
+//runs whichever --mode was picked, with the pixel coordinates in T
+template<typename T, typename Count>
+void computeMandelbrot(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height, Count* iterations_arr) {
+	if (RENDER_MODE == RenderMode::subdivide) {
+		mandelbrot_subdivide(x_start, x_end, y_start, y_end, image_width, image_height, iterations_arr);
+	} else if (RENDER_MODE == RenderMode::boundary) {
+		mandelbrot_boundary(x_start, x_end, y_start, y_end, image_width, image_height, iterations_arr);
+	} else if (RENDER_MODE == RenderMode::guess) {
+		mandelbrot_guess(x_start, x_end, y_start, y_end, image_width, image_height, iterations_arr);
+	} else {
+		MandelbrotTask<T, Count>* mandelbrotTask = new MandelbrotTask<T, Count>(iterations_arr, x_start, x_end, y_start, y_end, image_width, image_height);
+		lastTileStart = 0;
+		lastTileEnd = 0;
+		longestTile = 0;
+		previewTime = 0;
+		mirroredRows = 0;
+		//perturbation's coordinates are offsets from the reference, which isn't on the real axis
+		if (SYMMETRY && !PERTURBATION) {
+			mandelbrotTask->mirror_of = mirrorRows(y_start, y_end, image_height);
+			mirroredRows = int(image_height - std::count(mandelbrotTask->mirror_of.begin(), mandelbrotTask->mirror_of.end(), -1));
+			if (mirroredRows == 0) {
+				mandelbrotTask->mirror_of.clear();
+			}
+		}
+		tilesStartTime = std::chrono::steady_clock::now();
+		if (TILE_SIZE > 0 && TILE_ORDER == TileOrder::cost) {
+			TileCostTask<T>* costTask = new TileCostTask<T>(x_start, x_end, y_start, y_end, image_width, image_height);
+			costTask->mirror_of = &mandelbrotTask->mirror_of;
+			g_TS.AddTaskSetToPipe(costTask);
+			g_TS.WaitforTask(costTask);
+			mandelbrotTask->cost_order.resize(costTask->costs.size());
+			std::iota(mandelbrotTask->cost_order.begin(), mandelbrotTask->cost_order.end(), 0);
+			std::stable_sort(mandelbrotTask->cost_order.begin(), mandelbrotTask->cost_order.end(), [&](uint32_t a, uint32_t b) { return costTask->costs[a] > costTask->costs[b]; });
+			delete costTask;
+			const std::chrono::time_point<std::chrono::steady_clock> previewEndTime = std::chrono::steady_clock::now();
+			previewTime = std::chrono::duration_cast<std::chrono::microseconds>(previewEndTime - tilesStartTime).count();
+			tilesStartTime = previewEndTime;
+		}
+		g_TS.AddTaskSetToPipe(mandelbrotTask);
+		g_TS.WaitforTask(mandelbrotTask);
+		for (int y = 0; y < int(mandelbrotTask->mirror_of.size()); y++) {
+			if (mandelbrotTask->mirror_of[y] >= 0) {
+				std::copy_n(iterations_arr + mandelbrotTask->mirror_of[y] * image_width, image_width, iterations_arr + y * image_width);
+			}
+		}
+		if (!SAVE_ORBITS_FILE.empty()) {
+			mirrorOrbits(mandelbrotTask->orbits, mandelbrotTask->mirror_of, image_width);
+			packOrbits(mandelbrotTask->orbits);
+		}
+		delete mandelbrotTask;
+	}
+}
+
+//--precision=mixed (brute mode only): every tile starts out in the cheapest precision that isn't right at the edge of telling its own
+//pixels apart (with only MIXED_MARGIN_BITS to spare, vs PRECISION_MARGIN_BITS for the whole image), then gets checked for neighbors that
+//came out the same only because their coordinates got rounded together: pairs of neighboring pixels get redone in the next precision up,
+//and if too many that matched don't match anymore, the tile goes up a level
+//(comparing the counts directly wouldn't work, since pixels near the boundary come out different in every precision anyway)
+const int MIXED_TILE_SIZE = 64;
+const int MIXED_MARGIN_BITS = 4;
+const int MIXED_SAMPLE_STEP = 16;
+const double MIXED_MAX_COLLAPSED = 0.125; //fraction of the sampled pairs
+
+std::atomic<uint64_t> mixedTiles[int(Precision::double_double) + 1]; //per Precision the tile ended up in
+std::atomic<uint64_t> escalatedTiles = 0;
+
+template<typename T>
+struct Bounds {
+	T x_start, x_end, y_start, y_end;
+};
+
+template<typename Count>
+struct MixedPrecisionTask : public enki::ITaskSet {
+	Count* iterations_arr;
+	MixedPrecisionTask(Count* iterations_arr, const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height);
+
+	std::tuple<Bounds<float>, Bounds<double>, Bounds<long double>, Bounds<DoubleDouble>> bounds;
+	double pixel_size;
+	int image_width, image_height;
+	int tiles_x;
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+
+	template<typename T>
+	void computeTile(int x0, int x1, int y0, int y1, Count* block) const;
+	template<typename T>
+	bool neighborsHold(int x0, int x1, int y0, int y1, const Count* block) const;
+};
+
+//block gets the tile [x0, x1) x [y0, y1)
+template<typename Count>
+template<typename T>
+void MixedPrecisionTask<Count>::computeTile(int x0, int x1, int y0, int y1, Count* block) const {
+	const Bounds<T>& b = std::get<Bounds<T>>(bounds);
+	mandelbrot_helper(b.x_start, b.x_end, b.y_start, b.y_end, x0, x1, image_width, y0, y1, image_height, block);
+}
+
+//whether the neighbors that came out the same in block mostly still do in T
+template<typename Count>
+template<typename T>
+bool MixedPrecisionTask<Count>::neighborsHold(int x0, int x1, int y0, int y1, const Count* block) const {
+	const Bounds<T>& b = std::get<Bounds<T>>(bounds);
+	std::vector<T> cx_list, cy_list;
+	std::vector<bool> matched;
+	for (int y = y0 + MIXED_SAMPLE_STEP / 2; y < y1; y += MIXED_SAMPLE_STEP) {
+		for (int x = x0 + MIXED_SAMPLE_STEP / 2; x + 1 < x1; x += MIXED_SAMPLE_STEP) {
+			const T cy = rowCenter(y, b.y_start, b.y_end, image_height);
+			cx_list.push_back(pixelCenter(x, b.x_start, b.x_end, image_width));
+			cx_list.push_back(pixelCenter(x + 1, b.x_start, b.x_end, image_width));
+			cy_list.push_back(cy);
+			cy_list.push_back(cy);
+			const Count* row = block + (y - y0) * (x1 - x0) - x0;
+			matched.push_back(row[x] == row[x + 1]);
+		}
+	}
+	std::vector<Count> results(cx_list.size());
+	KernelStats stats;
+	compute_pixels(ListPixels<T>{ cx_list.data(), cy_list.data(), int(cx_list.size()) }, results.data(), stats);
+	addKernelStats(stats);
+
+	int collapsed = 0;
+	for (size_t i = 0; i < matched.size(); i++) {
+		collapsed += (matched[i] && results[2*i] != results[2*i + 1]);
+	}
+	return collapsed <= MIXED_MAX_COLLAPSED * matched.size();
+}
+
+template<typename Count>
+void MixedPrecisionTask<Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	std::vector<Count> block;
+	for (uint32_t tile = range_.start; tile < range_.end; tile++) {
+		const int x0 = int(tile % tiles_x) * MIXED_TILE_SIZE, x1 = std::min(x0 + MIXED_TILE_SIZE, image_width);
+		const int y0 = int(tile / tiles_x) * MIXED_TILE_SIZE, y1 = std::min(y0 + MIXED_TILE_SIZE, image_height);
+		block.resize((x1 - x0) * (y1 - y0));
+
+		//checking the tile's corners is enough, since the magnitude can only peak at one
+		const Bounds<double>& b = std::get<Bounds<double>>(bounds);
+		const double magnitude = std::max({
+			std::fabs(pixelCenter(x0, b.x_start, b.x_end, image_width)), std::fabs(pixelCenter(x1 - 1, b.x_start, b.x_end, image_width)),
+			std::fabs(rowCenter(y0, b.y_start, b.y_end, image_height)), std::fabs(rowCenter(y1 - 1, b.y_start, b.y_end, image_height)) });
+		Precision precision = precisionFor(magnitude, pixel_size, MIXED_MARGIN_BITS);
+		while (true) {
+			bool done = true;
+			switch (precision) {
+				case Precision::float_:
+					computeTile<float>(x0, x1, y0, y1, block.data());
+					done = neighborsHold<double>(x0, x1, y0, y1, block.data());
+					break;
+				case Precision::double_:
+					computeTile<double>(x0, x1, y0, y1, block.data());
+					done = neighborsHold<long double>(x0, x1, y0, y1, block.data());
+					break;
+				case Precision::long_double:
+					computeTile<long double>(x0, x1, y0, y1, block.data());
+					done = neighborsHold<DoubleDouble>(x0, x1, y0, y1, block.data());
+					break;
+				default:
+					computeTile<DoubleDouble>(x0, x1, y0, y1, block.data()); //nothing past it to check against
+					break;
+			}
+			if (done) {
+				break;
+			}
+			precision = Precision(int(precision) + 1);
+			if (precision == Precision::long_double && doubleDoubleBeatsLongDouble()) {
+				precision = Precision::double_double;
+			}
+			escalatedTiles++;
+		}
+		mixedTiles[int(precision)]++;
+
+		for (int y = y0; y < y1; y++) {
+			std::copy_n(block.data() + (y - y0) * (x1 - x0), x1 - x0, iterations_arr + y * image_width + x0);
+		}
+	}
+}
+
+template<typename Count>
+MixedPrecisionTask<Count>::MixedPrecisionTask(Count* iterations_arr, const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height) {
+	m_MinRange = 1;
+	this->iterations_arr = iterations_arr;
+	this->image_width = image_width;
+	this->image_height = image_height;
+	tiles_x = (image_width + MIXED_TILE_SIZE - 1) / MIXED_TILE_SIZE;
+	m_SetSize = tiles_x * ((image_height + MIXED_TILE_SIZE - 1) / MIXED_TILE_SIZE);
+
+	bounds = {
+		{ parseCoordinate<float>(x_start), parseCoordinate<float>(x_end), parseCoordinate<float>(y_start), parseCoordinate<float>(y_end) },
+		{ parseCoordinate<double>(x_start), parseCoordinate<double>(x_end), parseCoordinate<double>(y_start), parseCoordinate<double>(y_end) },
+		{ parseCoordinate<long double>(x_start), parseCoordinate<long double>(x_end), parseCoordinate<long double>(y_start), parseCoordinate<long double>(y_end) },
+		{ parseCoordinate<DoubleDouble>(x_start), parseCoordinate<DoubleDouble>(x_end), parseCoordinate<DoubleDouble>(y_start), parseCoordinate<DoubleDouble>(y_end) } };
+	const Bounds<DoubleDouble>& b = std::get<Bounds<DoubleDouble>>(bounds);
+	pixel_size = pixelSize(b.x_start, b.x_end, b.y_start, b.y_end, image_width, image_height);
+}
+
+//--resume-orbits: picks up the saved orbits in chunks
+const int RESUME_CHUNK_SIZE = 4096;
+
+template<typename T, typename Count>
+struct ResumeTask : public enki::ITaskSet {
+	ResumeTask(std::vector<SavedOrbit<T>>& orbits, Count* iterations_arr, T x_start, T x_end, T y_start, T y_end, int image_width, int image_height);
+
+	std::vector<SavedOrbit<T>>& orbits;
+	std::vector<uint8_t> running; //per orbit, whether it ran out of iterations again
+	Count* iterations_arr;
+	T x_start, x_end, y_start, y_end;
+	int image_width, image_height;
+
+	void ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) override;
+};
+
+template<typename T, typename Count>
+void ResumeTask<T, Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	for (uint32_t chunk_start = range_.start; chunk_start < range_.end; chunk_start += RESUME_CHUNK_SIZE) {
+		const int count = int(std::min<uint32_t>(RESUME_CHUNK_SIZE, range_.end - chunk_start));
+		std::vector<T> cx_list(count), cy_list(count), zx_list(count), zy_list(count);
+		for (int i = 0; i < count; i++) {
+			const SavedOrbit<T>& orbit = orbits[chunk_start + i];
+			cx_list[i] = pixelCenter(int(orbit.pixel % image_width), x_start, x_end, image_width);
+			cy_list[i] = rowCenter(int(orbit.pixel / image_width), y_start, y_end, image_height);
+			zx_list[i] = orbit.x;
+			zy_list[i] = orbit.y;
+		}
+		std::vector<Count> results(count);
+		KernelStats stats;
+		compute_pixels(OrbitPixels<T>{ cx_list.data(), cy_list.data(), zx_list.data(), zy_list.data(), running.data() + chunk_start, resumedFrom, count }, results.data(), stats);
+		addKernelStats(stats);
+		for (int i = 0; i < count; i++) {
+			iterations_arr[orbits[chunk_start + i].pixel] = results[i];
+			orbits[chunk_start + i].x = zx_list[i];
+			orbits[chunk_start + i].y = zy_list[i];
+		}
+	}
+}
+
+template<typename T, typename Count>
+ResumeTask<T, Count>::ResumeTask(std::vector<SavedOrbit<T>>& orbits, Count* iterations_arr, T x_start, T x_end, T y_start, T y_end, int image_width, int image_height) : orbits(orbits) {
+	m_SetSize = uint32_t(orbits.size());
+	m_MinRange = RESUME_CHUNK_SIZE;
+	running.resize(orbits.size());
+	this->iterations_arr = iterations_arr;
+	this->x_start = x_start;
+	this->x_end = x_end;
+	this->y_start = y_start;
+	this->y_end = y_end;
+	this->image_width = image_width;
+	this->image_height = image_height;
+}
+
+template<typename T, typename Count>
+void resumeOrbits(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height, Count* iterations_arr) {
+	std::vector<SavedOrbit<T>> orbits = unpackOrbits<T>();
+	//rows that get copied from their mirror image get copied again, orbits and all, so they come out like they would have all along
+	std::vector<int> mirror_of;
+	if (SYMMETRY) {
+		mirror_of = mirrorRows(y_start, y_end, image_height);
+		orbits.erase(std::remove_if(orbits.begin(), orbits.end(), [&](const SavedOrbit<T>& orbit) { return mirror_of[orbit.pixel / image_width] >= 0; }), orbits.end());
+	}
+	ResumeTask<T, Count>* resumeTask = new ResumeTask<T, Count>(orbits, iterations_arr, x_start, x_end, y_start, y_end, image_width, image_height);
+	g_TS.AddTaskSetToPipe(resumeTask);
+	g_TS.WaitforTask(resumeTask);
+
+	//only the ones that ran out of iterations again are worth saving
+	std::vector<SavedOrbit<T>> still_running;
+	for (size_t i = 0; i < orbits.size(); i++) {
+		if (resumeTask->running[i]) {
+			still_running.push_back(orbits[i]);
+		}
+	}
+	delete resumeTask;
+	for (int y = 0; y < int(mirror_of.size()); y++) {
+		if (mirror_of[y] >= 0) {
+			std::copy_n(iterations_arr + mirror_of[y] * image_width, image_width, iterations_arr + y * image_width);
+		}
+	}
+	mirrorOrbits(still_running, mirror_of, image_width);
+	packOrbits(still_running);
+}
+
+//--resume-orbits instead of computing the image: everything comes from the orbit file, except the orbits it saved get picked up and taken to MAX_ITER
+//(main() already switched PRECISION to the file's)
+template<typename Count>
+int resumeImage(const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height, Count* iterations_arr) {
+	const OrbitFileHeader header = loadOrbits(RESUME_ORBITS_FILE, iterations_arr);
+	if (header.image_width != image_width || header.image_height != image_height || header.x_start != std::stod(x_start) || header.x_end != std::stod(x_end)
+		|| header.y_start != std::stod(y_start) || header.y_end != std::stod(y_end)) {
+		throw std::runtime_error("\"" + RESUME_ORBITS_FILE + "\" is for a different view: [" + std::to_string(header.x_start) + ", " + std::to_string(header.x_end) + "] x ["
+			+ std::to_string(header.y_start) + ", " + std::to_string(header.y_end) + "], " + std::to_string(header.image_width) + "x" + std::to_string(header.image_height));
+	}
+	if (header.max_iter >= MAX_ITER) {
+		throw std::runtime_error("\"" + RESUME_ORBITS_FILE + "\" already went to " + std::to_string(header.max_iter) + " iterations, so the coloring's max iterations (" + std::to_string(MAX_ITER) + ") have to be higher to pick it up");
+	}
+	resumedFrom = header.max_iter;
+	resumedPixels = runningPixels;
+
+	//pixels that stopped at the old MAX_ITER without running out are inside the set, so they stay at MAX_ITER
+	for (int i = 0; i < image_width * image_height; i++) {
+		if (iterations_arr[i] == header.max_iter) {
+			iterations_arr[i] = MAX_ITER;
+		}
+	}
+	if (PRECISION == Precision::fixed) {
+		resumeOrbits(parseCoordinate<Fixed64>(x_start), parseCoordinate<Fixed64>(x_end), parseCoordinate<Fixed64>(y_start), parseCoordinate<Fixed64>(y_end), image_width, image_height, iterations_arr);
+		return sizeof(Fixed64);
+	} else if (PRECISION == Precision::float_) {
+		resumeOrbits(parseCoordinate<float>(x_start), parseCoordinate<float>(x_end), parseCoordinate<float>(y_start), parseCoordinate<float>(y_end), image_width, image_height, iterations_arr);
+		return sizeof(float);
+	} else if (PRECISION == Precision::double_) {
+		resumeOrbits(parseCoordinate<double>(x_start), parseCoordinate<double>(x_end), parseCoordinate<double>(y_start), parseCoordinate<double>(y_end), image_width, image_height, iterations_arr);
+		return sizeof(double);
+	} else if (PRECISION == Precision::long_double) {
+		resumeOrbits(parseCoordinate<long double>(x_start), parseCoordinate<long double>(x_end), parseCoordinate<long double>(y_start), parseCoordinate<long double>(y_end), image_width, image_height, iterations_arr);
+		return sizeof(long double);
+	} else {
+		resumeOrbits(parseCoordinate<DoubleDouble>(x_start), parseCoordinate<DoubleDouble>(x_end), parseCoordinate<DoubleDouble>(y_start), parseCoordinate<DoubleDouble>(y_end), image_width, image_height, iterations_arr);
+		return sizeof(DoubleDouble);
+	}
+}
+
+//computes every pixel with whatever precision, --mode, and checks were picked, and returns the size of the number type used, for the iteration cache
+template<typename Count>
+int computeImage(const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height, Count* iterations_arr) {
+	int float_size = 0;
+	if (!RESUME_ORBITS_FILE.empty()) {
+		float_size = resumeImage(x_start, x_end, y_start, y_end, image_width, image_height, iterations_arr);
+	} else if (PERTURBATION) {
+		deepZoom.reference = computeReferenceOrbit(0, 0);
+		//pixels get handed out as offsets from the reference in pixel units instead (see perturbation_pixels())
+		computeMandelbrot<float>(-float(image_width) / 2, float(image_width) / 2, -float(image_height) / 2, float(image_height) / 2, image_width, image_height, iterations_arr);
+		float_size = sizeof(double);
+	} else if (PRECISION == Precision::mixed) {
+		MixedPrecisionTask<Count>* mixedTask = new MixedPrecisionTask<Count>(iterations_arr, x_start, x_end, y_start, y_end, image_width, image_height);
+		g_TS.AddTaskSetToPipe(mixedTask);
+		g_TS.WaitforTask(mixedTask);
+		delete mixedTask;
+		float_size = mixedTiles[int(Precision::double_double)] ? sizeof(DoubleDouble) : mixedTiles[int(Precision::long_double)] ? sizeof(long double)
+			: mixedTiles[int(Precision::double_)] ? sizeof(double) : sizeof(float);
+	} else if (PRECISION == Precision::fixed) {
+		computeMandelbrot(parseCoordinate<Fixed64>(x_start), parseCoordinate<Fixed64>(x_end), parseCoordinate<Fixed64>(y_start), parseCoordinate<Fixed64>(y_end), image_width, image_height, iterations_arr);
+		float_size = sizeof(Fixed64);
+	} else if (PRECISION == Precision::float_) {
+		computeMandelbrot(parseCoordinate<float>(x_start), parseCoordinate<float>(x_end), parseCoordinate<float>(y_start), parseCoordinate<float>(y_end), image_width, image_height, iterations_arr);
+		float_size = sizeof(float);
+	} else if (PRECISION == Precision::double_) {
+		computeMandelbrot(parseCoordinate<double>(x_start), parseCoordinate<double>(x_end), parseCoordinate<double>(y_start), parseCoordinate<double>(y_end), image_width, image_height, iterations_arr);
+		float_size = sizeof(double);
+	} else if (PRECISION == Precision::long_double) {
+		computeMandelbrot(parseCoordinate<long double>(x_start), parseCoordinate<long double>(x_end), parseCoordinate<long double>(y_start), parseCoordinate<long double>(y_end), image_width, image_height, iterations_arr);
+		float_size = sizeof(long double);
+	} else {
+		computeMandelbrot(parseCoordinate<DoubleDouble>(x_start), parseCoordinate<DoubleDouble>(x_end), parseCoordinate<DoubleDouble>(y_start), parseCoordinate<DoubleDouble>(y_end), image_width, image_height, iterations_arr);
+		float_size = sizeof(DoubleDouble);
+	}
+	return float_size;
+}
+
+//--max-iter=auto: a small image of the same view (AUTO_SAMPLE_WIDTH pixels wide) gets computed with a max iterations starting at AUTO_FIRST_MAX_ITER,
+//doubling until doubling it again lets less than AUTO_ESCAPED_CHANGE more of the samples escape; that's where more iterations stop changing the image
+//(every try starts over, but they're small, and all of them together cost at most as much as the last one again)
+//nothing escaping yet doesn't count as settled while more than AUTO_UNDECIDED of the samples are still iterating instead of having been caught inside,
+//since deep views can take thousands of iterations before the first pixel escapes; AUTO_MAX_LIMIT stops views that never settle from doubling forever
+//it runs before the iteration counts' width gets picked, so the samples are always 32 bits
+const int AUTO_SAMPLE_WIDTH = 96;
+const int AUTO_FIRST_MAX_ITER = 256;
+const double AUTO_ESCAPED_CHANGE = 0.001;
+const double AUTO_UNDECIDED = 0.5;
+const int AUTO_MAX_LIMIT = 1 << 22;
+
+int autoMaxIter(const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height) {
+	const int sample_width = std::min(image_width, AUTO_SAMPLE_WIDTH);
+	const int sample_height = std::max(1, int(int64_t(image_height) * sample_width / image_width));
+	std::vector<uint32_t> samples(sample_width * sample_height);
+	//perturbation's offsets are in pixels, which are bigger in the sample
+	const double pixel_width = deepZoom.pixel_width, pixel_height = deepZoom.pixel_height;
+	deepZoom.pixel_width *= double(image_width) / sample_width;
+	deepZoom.pixel_height *= double(image_height) / sample_height;
+	const std::string save_orbits_file = SAVE_ORBITS_FILE;
+	SAVE_ORBITS_FILE = "";
+	//every row gets computed, even with SYMMETRY: the pixels in copied rows would be caught inside without the counters below seeing them
+	const bool symmetry = SYMMETRY;
+	SYMMETRY = false;
+	double undecided = 1;
+	auto escapedFraction = [&](int max_iter) {
+		MAX_ITER = max_iter;
+		const uint64_t caught = cardioidPixels + periodicPixels + derivativePixels;
+		computeImage(x_start, x_end, y_start, y_end, sample_width, sample_height, samples.data());
+		const double escaped = double(std::count_if(samples.begin(), samples.end(), [&](uint32_t iterations) { return iterations < uint32_t(max_iter); })) / samples.size();
+		undecided = 1 - escaped - double(cardioidPixels + periodicPixels + derivativePixels - caught) / samples.size();
+		return escaped;
+	};
+
+	const int limit = AUTO_MAX_LIMIT;
+	int max_iter = AUTO_FIRST_MAX_ITER;
+	double escaped = escapedFraction(max_iter);
+	double next_escaped = escaped;
+	while (max_iter <= limit / 2) {
+		next_escaped = escapedFraction(2 * max_iter);
+		if (next_escaped - escaped < AUTO_ESCAPED_CHANGE && (next_escaped > 0 || undecided <= AUTO_UNDECIDED)) {
+			break;
+		}
+		max_iter *= 2;
+		escaped = next_escaped;
+	}
+	std::cout << "max iterations: " << max_iter << " (" << (100.0 * escaped) << "% of " << samples.size() << " samples escaped, ";
+	if (max_iter > limit / 2) {
+		std::cout << "and twice as many is past the limit of " << limit << ")" << std::endl;
+	} else {
+		std::cout << (100.0 * next_escaped) << "% with twice as many)" << std::endl;
+	}
+
+	deepZoom.pixel_width = pixel_width;
+	deepZoom.pixel_height = pixel_height;
+	deepZoom.extraReferences.clear(); //they only went to the samples' max iterations
+	SAVE_ORBITS_FILE = save_orbits_file;
+	SYMMETRY = symmetry;
+
+	//the samples shouldn't count towards the real image's stats
+	usedLaneIterations = totalLaneIterations = 0;
+	cardioidPixels = periodicPixels = derivativePixels = computedPixels = glitchedPixels = skippedIterations = 0;
+	for (std::atomic<uint64_t>& tiles : mixedTiles) {
+		tiles = 0;
+	}
+	escalatedTiles = 0;
+	return max_iter;
+}
+
+//scales every coloring's iteration counts by the same factor, so the one that went to old_max_iter goes to max_iter (keeping them in order, and at least 1)
+void stretchColors(std::vector<ImageOutput>& outputs, int old_max_iter, int max_iter) {
+	for (ImageOutput& output : outputs) {
+		int previous = 0;
+		for (std::pair<int, Magick::ColorRGB>& color : output.colors) {
+			color.first = std::max(previous + 1, int(std::lround(double(color.first) * max_iter / old_max_iter)));
+			previous = color.first;
+		}
+	}
+}
+
+template<typename Count>
+void mandelbrot(int threadCount, const std::string& x_start, const std::string& x_end, const std::string& y_start, const std::string& y_end, int image_width, int image_height, std::vector<ImageOutput>& outputs) {
+	//calculate mandelbrot:
+
+	std::vector<Count> iterations_arr(image_width * image_height);
+	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	const int float_size = computeImage(x_start, x_end, y_start, y_end, image_width, image_height, iterations_arr.data());
+	std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+	std::cout << "mandelbrot: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
+	if (!PERTURBATION && PRECISION == Precision::mixed) {
+		std::cout << "precision: mixed, tiles:";
+		for (Precision precision : { Precision::float_, Precision::double_, Precision::long_double, Precision::double_double }) {
+			std::cout << " " << mixedTiles[int(precision)] << " " << precisionName(precision) << ",";
+		}
+		std::cout << " " << escalatedTiles << " escalations" << std::endl;
+	} else if (!PERTURBATION) {
+		std::cout << "precision: " << precisionName(PRECISION) << std::endl;
+	}
+	if (RENDER_MODE != RenderMode::brute) {
+		std::cout << "computed: " << computedPixels << " pixels (" << (100.0 * computedPixels / (uint64_t(image_width) * image_height)) << "%), the rest were filled in" << std::endl;
+	}
+	if (CARDIOID_CHECK) {
+		std::cout << "cardioid/bulb: " << cardioidPixels << " pixels skipped (" << (100.0 * cardioidPixels / (uint64_t(image_width) * image_height)) << "%)" << std::endl;
+	}
+	if (!RESUME_ORBITS_FILE.empty()) {
+		std::cout << "orbits: " << resumedPixels << " pixels picked up at " << resumedFrom << " iterations, " << runningPixels << " of them ran out again" << std::endl;
+	}
+	if (mirroredRows > 0) {
+		std::cout << "symmetry: " << mirroredRows << " rows copied from their mirror image" << std::endl;
+	}
+	if (PERIODICITY_CHECK) {
+		std::cout << "periodicity: " << periodicPixels << " pixels caught in a cycle" << std::endl;
+	}
+	if (DERIVATIVE_CHECK) {
+		std::cout << "derivative: " << derivativePixels << " pixels found inside an attracting cycle" << std::endl;
+	}
+	if (PERTURBATION) {
+		std::cout << "perturbation: reference orbit of " << deepZoom.reference.length() << " iterations at " << 32 * deepZoom.center_x.fractionLimbs() << " bits, " << deepZoom.extraReferences.size() << " more for glitches, " << glitchedPixels << " pixels still glitched" << std::endl;
+		if (BLA_SKIPPING) {
+			std::cout << "bla: " << deepZoom.reference.bla.levels.size() << " levels, " << skippedIterations << " iterations skipped" << std::endl;
+		}
+	}
+	std::cout << "kernels: " << simdLevelName(SIMD_LEVEL) << std::endl;
+	if (totalLaneIterations > 0) {
+		std::cout << "lane utilization: " << (100.0 * usedLaneIterations / totalLaneIterations) << "%" << std::endl;
+	}
+	if (lastTileEnd > 0) {
+		//the tail: how long the render went on after the last tile got handed out
+		std::cout << "tiles: longest " << (longestTile / 1000.0) << "ms, tail " << ((lastTileEnd - lastTileStart) / 1000.0) << "ms ("
+			<< (100.0 * (lastTileEnd - lastTileStart) / lastTileEnd) << "% of the render)";
+		if (TILE_ORDER == TileOrder::cost) {
+			std::cout << ", preview " << (previewTime / 1000.0) << "ms";
+		}
+		std::cout << std::endl;
+	}
+
+	if (VALIDATE) {
+		//brute force: every pixel gets iterated until it escapes or hits MAX_ITER
+		startTime = std::chrono::steady_clock::now();
+		const RenderMode render_mode = RENDER_MODE;
+		const bool cardioid_check = CARDIOID_CHECK, periodicity_check = PERIODICITY_CHECK, derivative_check = DERIVATIVE_CHECK, bla_skipping = BLA_SKIPPING;
+		const std::string save_orbits_file = SAVE_ORBITS_FILE, resume_orbits_file = RESUME_ORBITS_FILE;
+		RENDER_MODE = RenderMode::brute;
+		CARDIOID_CHECK = PERIODICITY_CHECK = DERIVATIVE_CHECK = BLA_SKIPPING = false; //(with PERTURBATION, the reference orbit gets recomputed, without the BLA table)
+		SAVE_ORBITS_FILE = RESUME_ORBITS_FILE = "";
+		deepZoom.extraReferences.clear(); //the render's glitch references have BLA tables, so they can't be reused
+		std::vector<Count> exhaustive_arr(image_width * image_height);
+		computeImage(x_start, x_end, y_start, y_end, image_width, image_height, exhaustive_arr.data());
+		SAVE_ORBITS_FILE = save_orbits_file;
+		RESUME_ORBITS_FILE = resume_orbits_file;
+		RENDER_MODE = render_mode;
+		CARDIOID_CHECK = cardioid_check;
+		PERIODICITY_CHECK = periodicity_check;
+		DERIVATIVE_CHECK = derivative_check;
+		BLA_SKIPPING = bla_skipping;
+
+		uint64_t different = 0, wrongly_inside = 0;
+		for (size_t i = 0; i < iterations_arr.size(); i++) {
+			different += (iterations_arr[i] != exhaustive_arr[i]);
+			wrongly_inside += (iterations_arr[i] == MAX_ITER && exhaustive_arr[i] != MAX_ITER);
+		}
+		endTime = std::chrono::steady_clock::now();
+		std::cout << "validate: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms, " << different << " pixels ("
+			<< (100.0 * different / iterations_arr.size()) << "%) differ from iterating every pixel all the way, " << wrongly_inside << " of them wrongly counted as inside" << std::endl;
+	}
+
+	if (!SAVE_ITERATIONS_FILE.empty()) {
+		startTime = std::chrono::steady_clock::now();
+		saveIterations(SAVE_ITERATIONS_FILE, iterations_arr.data(), std::stod(x_start), std::stod(x_end), std::stod(y_start), std::stod(y_end), image_width, image_height, float_size);
+		endTime = std::chrono::steady_clock::now();
+		std::cout << "save iterations: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
+	}
+	if (!SAVE_ORBITS_FILE.empty()) {
+		startTime = std::chrono::steady_clock::now();
+		saveOrbits(SAVE_ORBITS_FILE, iterations_arr.data(), std::stod(x_start), std::stod(x_end), std::stod(y_start), std::stod(y_end), image_width, image_height);
+		endTime = std::chrono::steady_clock::now();
+		std::cout << "save orbits: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms, " << runningPixels << " pixels still running" << std::endl;
+	}
+
+	writeImages(iterations_arr.data(), image_width, image_height, MAX_ITER, outputs);
+}
+
+template<typename T, typename Count>
+void MandelbrotTask<T, Count>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	//[x0, x1) x [y0, y1), in runs of rows that don't get copied from their mirror image afterwards
+	std::vector<Count> block;
+	auto computeRows = [&](int x0, int x1, int y0, int y1) {
+		for (int run_start = y0; run_start < y1; ) {
+			if (!mirror_of.empty() && mirror_of[run_start] >= 0) {
+				run_start++;
+				continue;
+			}
+			int run_end = run_start + 1;
+			while (run_end < y1 && (mirror_of.empty() || mirror_of[run_end] < 0)) {
+				run_end++;
+			}
+			const bool whole_rows = (x0 == 0 && x1 == image_width);
+			Count* destination = iterations_arr + run_start * image_width;
+			if (!whole_rows) {
+				block.resize((x1 - x0) * (run_end - run_start));
+				destination = block.data();
+			}
+			if (SAVE_ORBITS_FILE.empty()) {
+				mandelbrot_helper(x_start, x_end, y_start, y_end, x0, x1, image_width, run_start, run_end, image_height, destination);
+			} else {
+				std::vector<SavedOrbit<T>> run_orbits;
+				mandelbrot_orbits(x_start, x_end, y_start, y_end, x0, x1, image_width, run_start, run_end, image_height, destination, run_orbits);
+				std::lock_guard<std::mutex> lock(orbits_mutex);
+				orbits.insert(orbits.end(), run_orbits.begin(), run_orbits.end());
+			}
+			if (!whole_rows) {
+				for (int y = run_start; y < run_end; y++) {
+					std::copy_n(block.data() + (y - run_start) * (x1 - x0), x1 - x0, iterations_arr + y * image_width + x0);
+				}
+			}
+			run_start = run_end;
+		}
+	};
+
+	if (TILE_SIZE == 0) {
+		computeRows(0, image_width, range_.start, range_.end);
+		return;
+	}
+
+	auto computeTile = [&](int tile_x, int tile_y) {
+		const int64_t start = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tilesStartTime).count();
+		atomicMax(lastTileStart, start);
+
+		const int x0 = tile_x * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, image_width);
+		const int y0 = tile_y * TILE_SIZE, y1 = std::min(y0 + TILE_SIZE, image_height);
+		computeRows(x0, x1, y0, y1);
+
+		const int64_t end = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tilesStartTime).count();
+		atomicMax(lastTileEnd, end);
+		atomicMax(longestTile, end - start);
+	};
+
+	if (!cost_order.empty()) {
+		//whichever thread gets here first takes the most expensive tile left, whatever range it was given
+		for (uint32_t i = range_.start; i < range_.end; i++) {
+			const uint32_t tile = cost_order[next_tile++];
+			computeTile(int(tile % tiles_x), int(tile / tiles_x));
+		}
+		return;
+	}
+
+	const uint32_t square_tiles = uint32_t(curve_side) * curve_side;
+	for (uint32_t index = range_.start; index < range_.end; index++) {
+		int tile_x, tile_y;
+		curveTile(index % square_tiles, curve_side, tile_x, tile_y);
+		if (tiles_x >= tiles_y) {
+			tile_x += int(index / square_tiles) * curve_side;
+		} else {
+			std::swap(tile_x, tile_y);
+			tile_y += int(index / square_tiles) * curve_side;
+		}
+		if (tile_x >= tiles_x || tile_y >= tiles_y) {
+			continue;
+		}
+		computeTile(tile_x, tile_y);
+	}
+}
+
+template<typename T, typename Count>
+MandelbrotTask<T, Count>::MandelbrotTask(Count* iterations_arr, T x_start, T x_end, T y_start, T y_end, int image_width, int image_height) {
+	m_MinRange = 1; //smaller ranges don't help tiny images, but they slightly help very large images
+	if (TILE_SIZE == 0) {
+		m_SetSize = image_height;
+	} else {
+		tiles_x = (image_width + TILE_SIZE - 1) / TILE_SIZE;
+		tiles_y = (image_height + TILE_SIZE - 1) / TILE_SIZE;
+		curve_side = int(std::bit_ceil(unsigned(std::min(tiles_x, tiles_y))));
+		const int squares = (std::max(tiles_x, tiles_y) + curve_side - 1) / curve_side;
+		m_SetSize = (TILE_ORDER == TileOrder::cost) ? uint32_t(tiles_x) * tiles_y : uint32_t(squares) * curve_side * curve_side;
+	}
+	this->iterations_arr = iterations_arr;
+	this->x_start = x_start;
+	this->x_end = x_end;
+	this->y_start = y_start;
+	this->y_end = y_end;
+	this->image_width = image_width;
+	this->image_height = image_height;
+}
+
+template<typename T>
+void TileCostTask<T>::ExecuteRange(enki::TaskSetPartition range_, uint32_t threadnum_) {
+	std::vector<uint32_t> samples; //(only timed, so the width doesn't matter)
+	for (uint32_t tile = range_.start; tile < range_.end; tile++) {
+		const int x0 = int(tile % tiles_x) * TILE_SIZE, x1 = std::min(x0 + TILE_SIZE, image_width);
+		const int y0 = int(tile / tiles_x) * TILE_SIZE, y1 = std::min(y0 + TILE_SIZE, image_height);
+		if (!mirror_of->empty() && std::all_of(mirror_of->begin() + y0, mirror_of->begin() + y1, [](int row) { return row >= 0; })) {
+			costs[tile] = 0;
+			continue;
+		}
+		//start half a step in, so small tiles still get a sample from their middle
+		const int sample_x0 = x0 + std::min(PREVIEW_STEP / 2, (x1 - x0) / 2);
+		const int sample_y0 = y0 + std::min(PREVIEW_STEP / 2, (y1 - y0) / 2);
+		samples.resize(((x1 - sample_x0 + PREVIEW_STEP - 1) / PREVIEW_STEP) * ((y1 - sample_y0 + PREVIEW_STEP - 1) / PREVIEW_STEP));
+
+		std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+		mandelbrot_helper(x_start, x_end, y_start, y_end, sample_x0, x1, image_width, sample_y0, y1, image_height, samples.data(), PREVIEW_STEP);
+		std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+		costs[tile] = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	}
+}
+
+template<typename T>
+TileCostTask<T>::TileCostTask(T x_start, T x_end, T y_start, T y_end, int image_width, int image_height) {
+	m_MinRange = 1;
+	tiles_x = (image_width + TILE_SIZE - 1) / TILE_SIZE;
+	const int tiles_y = (image_height + TILE_SIZE - 1) / TILE_SIZE;
+	m_SetSize = uint32_t(tiles_x) * tiles_y;
+	costs.resize(m_SetSize);
+	this->x_start = x_start;
+	this->x_end = x_end;
+	this->y_start = y_start;
+	this->y_end = y_end;
+	this->image_width = image_width;
+	this->image_height = image_height;
+}
+
+
+
+//returns false if the option isn't recognized
+bool parseOption(const std::string& option) {
+	const size_t equals_pos = option.find('=');
+	const std::string name = option.substr(0, equals_pos);
+	const std::string value = (equals_pos == std::string::npos) ? "" : option.substr(equals_pos+1);
+
+	if (name == "--no-cardioid") {
+		CARDIOID_CHECK = false;
+	} else if (name == "--no-periodicity") {
+		PERIODICITY_CHECK = false;
+	} else if (name == "--no-symmetry") {
+		SYMMETRY = false;
+	} else if (name == "--derivative") {
+		DERIVATIVE_CHECK = true;
+	} else if (name == "--validate") {
+		VALIDATE = true;
+	} else if (name == "--perturbation") {
+		PERTURBATION = true;
+	} else if (name == "--reference-bits" && !value.empty()) {
+		REFERENCE_BITS = std::stoi(value);
+		if (REFERENCE_BITS <= 0) {
+			return false;
+		}
+	} else if (name == "--max-iter") {
+		if (value == "auto") {
+			AUTO_MAX_ITER = true;
+		} else {
+			return false;
+		}
+	} else if (name == "--no-bla") {
+		BLA_SKIPPING = false;
+	} else if (name == "--save-iterations" && !value.empty()) {
+		SAVE_ITERATIONS_FILE = value;
+	} else if (name == "--save-orbits" && !value.empty()) {
+		SAVE_ORBITS_FILE = value;
+	} else if (name == "--resume-orbits" && !value.empty()) {
+		RESUME_ORBITS_FILE = value;
+	} else if (name == "--recolor" && !value.empty()) {
+		RECOLOR_FILE = value;
+	} else if (name == "--mode") {
+		if (value == "brute") {
+			RENDER_MODE = RenderMode::brute;
+		} else if (value == "subdivide") {
+			RENDER_MODE = RenderMode::subdivide;
+		} else if (value == "boundary") {
+			RENDER_MODE = RenderMode::boundary;
+		} else if (value == "guess") {
+			RENDER_MODE = RenderMode::guess;
+		} else {
+			return false;
+		}
+	} else if (name == "--tile-size" && !value.empty()) {
+		TILE_SIZE = std::stoi(value);
+		if (TILE_SIZE < 0) {
+			return false;
+		}
+	} else if (name == "--tile-order") {
+		if (value == "hilbert") {
+			TILE_ORDER = TileOrder::hilbert;
+		} else if (value == "morton") {
+			TILE_ORDER = TileOrder::morton;
+		} else if (value == "cost") {
+			TILE_ORDER = TileOrder::cost;
+		} else {
+			return false;
+		}
+	} else if (name == "--precision") {
+		if (value == "auto") {
+			PRECISION = Precision::automatic;
+		} else if (value == "float") {
+			PRECISION = Precision::float_;
+		} else if (value == "double") {
+			PRECISION = Precision::double_;
+		} else if (value == "long-double") {
+			PRECISION = Precision::long_double;
+		} else if (value == "double-double") {
+			PRECISION = Precision::double_double;
+		} else if (value == "mixed") {
+			PRECISION = Precision::mixed;
+		} else if (value == "fixed") {
+			PRECISION = Precision::fixed;
+		} else {
+			return false;
+		}
+	} else if (name == "--kernel") {
+		if (value == "scalar") {
+			KERNEL_TYPE = KernelType::scalar;
+		} else if (value == "interleaved") {
+			KERNEL_TYPE = KernelType::interleaved;
+		} else if (value == "simd") {
+			KERNEL_TYPE = KernelType::simd;
+		} else if (value == "refill") {
+			KERNEL_TYPE = KernelType::refill;
+		} else {
+			return false;
+		}
+#if defined(__x86_64__)
+	} else if (name == "--simd") {
+		if (value == "sse2") {
+			SIMD_LEVEL = SimdLevel::sse2;
+		} else if (value == "avx2") {
+			SIMD_LEVEL = SimdLevel::avx2;
+		} else if (value == "avx512") {
+			SIMD_LEVEL = SimdLevel::avx512;
+		} else {
+			return false;
+		}
+#endif
+	} else {
+		return false;
+	}
+	return true;
+}
+
+//args[first] is the main output, optionally followed by its coloring file, then any number of "<coloring file>:<output name>" pairs
+//max iterations end up as the highest of all the colorings
+std::vector<ImageOutput> parseOutputs(const std::vector<std::string>& args, size_t first) {
+	size_t pairs_start = first + 1;
+	if (args.size() > first + 1 && args[first + 1].find(':') == std::string::npos) {
+		readColorFileAndSetColors(args[first + 1]);
+		pairs_start++;
+	}
+	std::vector<ImageOutput> outputs = { { args[first], iterationColors } };
+
+	for (size_t i = pairs_start; i < args.size(); i++) {
+		const size_t colon_pos = args[i].find(':'); //the first one, since ImageMagick output names can have a "format:" prefix
+		if (colon_pos == std::string::npos) {
+			throw std::runtime_error("Expected <coloring file>:<output name>, got \"" + args[i] + "\"");
+		}
+		outputs.push_back({ args[i].substr(colon_pos+1), readColorFile(args[i].substr(0, colon_pos)) });
+		MAX_ITER = std::max(MAX_ITER, outputs.back().colors.back().first);
+	}
+	return outputs;
+}
+
+int main(int argc, char** argv) {
+	SIMD_LEVEL = bestSimdLevel();
+
+	//options start with "--" and can go anywhere; everything else is positional
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = std::string(argv[i]);
+		if (arg.rfind("--", 0) == 0) {
+			if (!parseOption(arg)) {
+				std::cout << "unknown option: " << arg << std::endl;
+				return 1;
+			}
+		} else {
+			args.push_back(arg);
+		}
+	}
+	if (SIMD_LEVEL > bestSimdLevel()) {
+		std::cout << "this CPU doesn't support --simd=" << simdLevelName(SIMD_LEVEL) << " (the best it can do is " << simdLevelName(bestSimdLevel()) << ")" << std::endl;
+		return 1;
+	}
+
+	if (!RECOLOR_FILE.empty()) {
+		//the bounds and size come from the iteration cache
+		if (args.size() < 2) {
+			std::cout << "usage: " << argv[0] << " <num_threads> <output_name> [<optional coloring file>] [<coloring file>:<output name> ...] --recolor=<iteration cache>" << std::endl;
+			return 1;
+		}
+		Magick::InitializeMagick(argv[0]);
+		std::vector<ImageOutput> outputs = parseOutputs(args, 1);
+		g_TS.Initialize(std::max(1, std::stoi(args[0])));
+
+		std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+		recolor(RECOLOR_FILE, outputs);
+		std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
+		std::cout << "Time taken: " << std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count() << "ms" << std::endl;
+		return 0;
+	}
+
+	if (args.size() < 8) {
+		std::cout << "usage: " << argv[0] << " <num_threads> <x_start> <x_end> <y_start> <y_end> <image_x_size> <image_y_size> <output_name> [<optional coloring file>] [<coloring file>:<output name> ...] [--mode=brute|subdivide|boundary|guess] [--tile-size=<n>] [--tile-order=hilbert|morton|cost] [--kernel=refill|simd|interleaved|scalar] [--simd=sse2|avx2|avx512] [--precision=auto|float|double|long-double|double-double|mixed|fixed] [--no-cardioid] [--no-periodicity] [--no-symmetry] [--derivative] [--validate] [--perturbation] [--reference-bits=<n>] [--no-bla] [--max-iter=auto] [--save-iterations=<file>] [--save-orbits=<file>] [--resume-orbits=<file>]" << std::endl;
+		std::cout << "   or: " << argv[0] << " <num_threads> <output_name> [<optional coloring file>] [<coloring file>:<output name> ...] --recolor=<iteration cache>" << std::endl;
+		return 1;
+	}
+	Magick::InitializeMagick(argv[0]);
+
+	int threadCount; //std::thread::hardware_concurrency() exists but there's no need to use it
+	int image_width, image_height;
+
+	threadCount = std::stoi(args[0]);
+	threadCount = (threadCount < 1) ? 1 : threadCount;
+	image_width  = std::stoi(args[5]);
+	image_height = std::stoi(args[6]);
+	std::vector<ImageOutput> outputs = parseOutputs(args, 7);
+
+	if (PERTURBATION) {
+		//the bounds get parsed with enough precision for every digit given (wherever the exponent puts them), since even double-double would cut them off
+		int parse_limbs = 0;
+		for (int i = 1; i <= 4; i++) {
+			parse_limbs = std::max(parse_limbs, FixedPoint::fractionLimbsFor(args[i]) + 2);
+		}
+		const FixedPoint fixed_x_start = FixedPoint::fromString(args[1], parse_limbs);
+		const FixedPoint fixed_x_end   = FixedPoint::fromString(args[2], parse_limbs);
+		const FixedPoint fixed_y_start = FixedPoint::fromString(args[3], parse_limbs);
+		const FixedPoint fixed_y_end   = FixedPoint::fromString(args[4], parse_limbs);
+		deepZoom.pixel_width  = (fixed_x_end - fixed_x_start).toDouble() / image_width;
+		deepZoom.pixel_height = (fixed_y_end - fixed_y_start).toDouble() / image_height;
+		deepZoom.max_dc = std::hypot(deepZoom.pixel_width * image_width, deepZoom.pixel_height * image_height);
+
+		//the reference orbit needs to tell pixels apart, plus 64 bits for rounding errors to build up in
+		const double pixel_size = std::min(std::fabs(deepZoom.pixel_width), std::fabs(deepZoom.pixel_height));
+		const int limbs = (REFERENCE_BITS > 0) ? (REFERENCE_BITS + 31) / 32 : std::max(2, int(std::ceil((64 - std::log2(pixel_size)) / 32)));
+		deepZoom.center_x = (fixed_x_start + fixed_x_end).half().withFractionLimbs(limbs);
+		deepZoom.center_y = -(fixed_y_start + fixed_y_end).half().withFractionLimbs(limbs); //flipped like in mandelbrot_helper()
+
+		//neither of these work on offsets from a reference
+		CARDIOID_CHECK = false;
+		PERIODICITY_CHECK = false;
+		DERIVATIVE_CHECK = false;
+	}
+	if (DERIVATIVE_CHECK && !PERIODICITY_CHECK) {
+		std::cout << "--derivative works off the periodicity check's checkpoints, so it's off too" << std::endl;
+		DERIVATIVE_CHECK = false;
+	}
+	if (DERIVATIVE_CHECK && PRECISION == Precision::fixed) {
+		std::cout << "--precision=fixed can't hold the derivatives --derivative needs, so it's off" << std::endl;
+		DERIVATIVE_CHECK = false;
+	}
+	if (!PERTURBATION && PRECISION == Precision::fixed) {
+		//past that, orbits can overflow Fixed64 before they get checked for escaping (and there's nothing out there anyway)
+		for (int i = 1; i <= 4; i++) {
+			if (std::fabs(std::stod(args[i])) > 2) {
+				std::cout << "--precision=fixed needs the bounds to be within [-2, 2]" << std::endl;
+				return 1;
+			}
+		}
+	}
+	if ((!SAVE_ORBITS_FILE.empty() || !RESUME_ORBITS_FILE.empty()) && (PERTURBATION || PRECISION == Precision::mixed)) {
+		std::cout << "--save-orbits and --resume-orbits don't work with --perturbation or --precision=mixed" << std::endl;
+		return 1;
+	}
+	if (!SAVE_ORBITS_FILE.empty() && RESUME_ORBITS_FILE.empty() && RENDER_MODE != RenderMode::brute) {
+		std::cout << "--save-orbits only works with --mode=brute (the other modes fill pixels in without an orbit), switching to it" << std::endl;
+		RENDER_MODE = RenderMode::brute;
+	}
+	if (AUTO_MAX_ITER && !RESUME_ORBITS_FILE.empty()) {
+		std::cout << "--resume-orbits goes to the coloring file's max iterations, so --max-iter=auto is off" << std::endl;
+		AUTO_MAX_ITER = false;
+	}
+	if (!RESUME_ORBITS_FILE.empty()) {
+		//the orbits have to keep going in the precision they were saved in
+		std::ifstream file;
+		const Precision precision = Precision(openOrbits(RESUME_ORBITS_FILE, file).precision);
+		if (PRECISION != Precision::automatic && PRECISION != precision) {
+			std::cout << "\"" << RESUME_ORBITS_FILE << "\" was saved with --precision=" << precisionName(precision) << ", so that's what it's picked up with" << std::endl;
+		}
+		PRECISION = precision;
+	}
+	if (!PERTURBATION && PRECISION == Precision::mixed && RENDER_MODE != RenderMode::brute) {
+		std::cout << "--precision=mixed only works with --mode=brute, picking one precision for the whole image instead" << std::endl;
+		PRECISION = Precision::automatic;
+	}
+	if (!PERTURBATION && PRECISION == Precision::automatic) {
+		PRECISION = pickPrecision(args[1], args[2], args[3], args[4], image_width, image_height);
+	}
+	g_TS.Initialize(threadCount);
+
+	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+
+	if (AUTO_MAX_ITER) {
+		const int old_max_iter = MAX_ITER;
+		MAX_ITER = autoMaxIter(args[1], args[2], args[3], args[4], image_width, image_height);
+		stretchColors(outputs, old_max_iter, MAX_ITER);
+		std::cout << "sampling: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() << "ms" << std::endl;
+	}
+
+	//iteration counts only get 32 bits when MAX_ITER (plus the two markers) doesn't fit in 16, since 16 is half the memory to fill and color
+	if (MAX_ITER > std::numeric_limits<uint16_t>::max() - 2) {
+		mandelbrot<uint32_t>(threadCount, args[1], args[2], args[3], args[4], image_width, image_height, outputs);
+	} else {
+		mandelbrot<uint16_t>(threadCount, args[1], args[2], args[3], args[4], image_width, image_height, outputs);
+	}
 
 	std::chrono::time_point<std::chrono::steady_clock> endTime = std::chrono::steady_clock::now();
 